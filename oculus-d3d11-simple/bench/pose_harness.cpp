@@ -0,0 +1,18 @@
+// Evaluates pose prediction against a trace recorded with the sample's --record-poses, see
+// RunPoseHarness.
+//
+// Usage: pose_harness <trace>
+
+#include "pose_predictor.h"
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        cerr << "Usage: pose_harness <trace>" << endl;
+        return 1;
+    }
+    return RunPoseHarness(argv[1]);
+}
@@ -0,0 +1,206 @@
+// Benchmarks for the platform independent scene code in scene_core. Prints one JSON object per
+// line and benchmark so results can be collected by CI.
+//
+// Usage: scene_bench [--max-boxes <n>] [--min-time <seconds>]
+
+#include "scene_core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace OVR;
+using namespace std;
+
+// Runs f until minTime has passed, at least once, and returns its fastest run in nanoseconds.
+template <typename Func>
+double FastestRunNs(double minTime, int& runs, Func f) {
+    using Clock = chrono::high_resolution_clock;
+    auto fastest = chrono::duration<double, nano>::max();
+    const auto start = Clock::now();
+    runs = 0;
+    do {
+        const auto runStart = Clock::now();
+        f();
+        fastest = min<chrono::duration<double, nano>>(fastest, Clock::now() - runStart);
+        ++runs;
+    } while (chrono::duration<double>(Clock::now() - start).count() < minTime);
+    return fastest.count();
+}
+
+void Report(const char* benchmark, size_t boxes, size_t items, int runs, double ns) {
+    cout << "{\"benchmark\": \"" << benchmark << "\", \"boxes\": " << boxes
+         << ", \"items\": " << items << ", \"runs\": " << runs << ", \"ns\": " << ns
+         << ", \"ns_per_item\": " << ns / max<size_t>(items, 1) << "}" << endl;
+}
+
+// Boxes scattered through a 100m cube, the same for every run.
+vector<BoxDesc> RandomBoxes(size_t count) {
+    mt19937 rng{42};
+    uniform_real_distribution<float> position{-50.0f, 50.0f}, extent{0.05f, 2.0f};
+    vector<BoxDesc> boxes(count);
+    for (auto& box : boxes) {
+        box.x1 = position(rng);
+        box.y1 = position(rng);
+        box.z1 = position(rng);
+        box.x2 = box.x1 + extent(rng);
+        box.y2 = box.y1 + extent(rng);
+        box.z2 = box.z1 + extent(rng);
+        box.c = Mesh::Color(static_cast<unsigned char>(rng()), 128, 128);
+    }
+    return boxes;
+}
+
+// Stands in for DirectX11 in DrawList::Render, copying the uniforms per draw as the real Map does.
+struct StubDevice {
+    UniformBlock uniforms;
+    vector<unsigned char> mapped;
+    size_t draws = 0, indexCount = 0;
+
+    StubDevice() {
+        uniforms.offsets["World"] = 0;
+        uniforms.data.resize(sizeof(Matrix4f));
+        mapped.resize(uniforms.data.size());
+    }
+
+    void SetUniform(const char* name, int n, const float* v) { uniforms.Set(name, n, v); }
+    template <typename Model>
+    void Draw(const Model& model) {
+        memcpy(mapped.data(), uniforms.data.data(), uniforms.data.size());
+        indexCount += model.indexCount;
+        ++draws;
+    }
+};
+
+struct StubModel {
+    Vector3f pos;
+    size_t indexCount;
+    BoundingBox bounds;
+
+    Matrix4f GetMatrix() const { return Matrix4f::Translation(pos); }
+    bool IsUploaded() const { return true; }
+    uintptr_t SortKey() const { return indexCount; }
+};
+
+int main(int argc, char* argv[]) {
+    size_t maxBoxes = 1000000;
+    double minTime = 0.1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (string{argv[i]} == "--max-boxes") maxBoxes = stoul(argv[i + 1]);
+        if (string{argv[i]} == "--min-time") minTime = stod(argv[i + 1]);
+    }
+
+    // 44 boxes is the sample room
+    const size_t sceneSizes[] = {44, 1000, 10000, 100000, 1000000};
+    int runs = 0;
+
+    // Textures, as generated by Scene::Scene, independent of scene size
+    {
+        const int texCount = 5, texWidthHeight = 256;
+        const auto ns = FastestRunNs(minTime, runs, [&] {
+            for (int k = 0; k < texCount; ++k) {
+                TextureData tex{texWidthHeight, texWidthHeight};
+                FillRoomTexture(tex, k);
+                tex.BuildMips();
+            }
+        });
+        Report("texture_generation", 0, texCount * texWidthHeight * texWidthHeight, runs, ns);
+    }
+
+    // View matrices and constants for both eyes, as built per frame
+    {
+        const int frames = 10000;
+        const Quatf orientation{0.1f, 0.2f, 0.0f, 0.97f};
+        const auto proj = Matrix4f::PerspectiveRH(1.6f, 0.9f, 0.2f, 1000.0f);
+        ViewConstants constants[2];
+        const auto ns = FastestRunNs(minTime, runs, [&] {
+            for (int frame = 0; frame < frames; ++frame)
+                for (int eye = 0; eye < 2; ++eye) {
+                    const Vector3f eyePos{eye ? 0.032f : -0.032f, 0.0f, 0.0f};
+                    const auto view = EyeViewMatrix(3.14f + frame * 1e-4f, Vector3f{0, 1.6f, -5},
+                                                    orientation.Normalized(), eyePos);
+                    constants[eye] = ViewConstants{proj.Transposed(), view.Transposed()};
+                }
+        });
+        Report("eye_matrices", 0, frames * 2, runs, ns);
+    }
+
+    for (auto boxCount : sceneSizes) {
+        if (boxCount > maxBoxes) break;
+        const auto boxes = RandomBoxes(boxCount);
+
+        {
+            const auto ns = FastestRunNs(minTime, runs, [&] {
+                vector<Mesh> meshes((boxCount + MaxBoxesPerMesh - 1) / MaxBoxesPerMesh);
+                for (size_t i = 0; i < boxCount; ++i) {
+                    const auto& b = boxes[i];
+                    meshes[i / MaxBoxesPerMesh].AddSolidColorBox(b.x1, b.y1, b.z1, b.x2, b.y2,
+                                                                 b.z2, b.c);
+                }
+            });
+            Report("add_solid_color_box", boxCount, boxCount, runs, ns);
+        }
+
+        {
+            const auto ns = FastestRunNs(minTime, runs, [&] {
+                vector<Mesh> meshes((boxCount + MaxBoxesPerMesh - 1) / MaxBoxesPerMesh);
+                for (size_t first = 0; first < boxCount; first += MaxBoxesPerMesh)
+                    meshes[first / MaxBoxesPerMesh].AddSolidColorBoxes(
+                        &boxes[first], min(MaxBoxesPerMesh, boxCount - first));
+            });
+            Report("add_solid_color_boxes", boxCount, boxCount, runs, ns);
+        }
+
+        {
+            const auto ns = FastestRunNs(minTime, runs,
+                                         [&] { BuildBoxMeshes(boxes.data(), boxCount); });
+            Report("build_box_meshes", boxCount, boxCount, runs, ns);
+        }
+
+        {
+            UniformBlock uniforms;
+            uniforms.offsets["World"] = 0;
+            uniforms.data.resize(sizeof(Matrix4f));
+            const auto world = Matrix4f::Translation(Vector3f{1, 2, 3});
+            const auto ns = FastestRunNs(minTime, runs, [&] {
+                for (size_t i = 0; i < boxCount; ++i) uniforms.Set("World", 16, &world.M[0][0]);
+            });
+            Report("set_uniform", boxCount, boxCount, runs, ns);
+        }
+
+        // One model per box, the worst case for submission. Two eyes and a spectator looking
+        // from the middle of the boxes, as culled and drawn per frame.
+        {
+            vector<unique_ptr<StubModel>> models;
+            for (const auto& b : boxes) {
+                const BoundingBox bounds{Vector3f{0, 0, 0},
+                                         Vector3f{b.x2 - b.x1, b.y2 - b.y1, b.z2 - b.z1}};
+                models.emplace_back(new StubModel{Vector3f{b.x1, b.y1, b.z1}, 36, bounds});
+            }
+            const auto proj = Matrix4f::PerspectiveRH(1.6f, 0.9f, 0.2f, 1000.0f);
+            vector<Frustum> frustums;
+            for (const float eyeX : {-0.032f, 0.032f, 0.0f})
+                frustums.push_back(Frustum{
+                    proj * EyeViewMatrix(0.5f, Vector3f{0, 0, 0}, Quatf{}, Vector3f{eyeX, 0, 0})});
+
+            DrawList<StubModel> drawList;
+            auto ns = FastestRunNs(minTime, runs, [&] {
+                drawList.Build(models, frustums.data(), frustums.size());
+            });
+            Report("build_draw_list", boxCount, models.size(), runs, ns);
+
+            // Items are the draws view 0 issues, not the models visible in any view
+            StubDevice device;
+            drawList.Render(device, 0);
+            const auto viewDraws = device.draws;
+            ns = FastestRunNs(minTime, runs, [&] { drawList.Render(device, 0); });
+            Report("render_view", boxCount, viewDraws, runs, ns);
+        }
+    }
+    return 0;
+}
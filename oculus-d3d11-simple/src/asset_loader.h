@@ -0,0 +1,155 @@
+// Background asset production with a bounded, budgeted hand over of GPU uploads to the render
+// thread. Only depends on the standard library so it can be driven by a stand-in device.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bounded queue of pending GPU uploads. Producers block while it is full, the render thread
+// drains it once per frame within a byte budget. Templated on the upload target so the queue
+// can be driven by a stand-in device.
+template <typename Target>
+struct UploadQueue {
+    using UploadFunc = std::function<void(Target&)>;
+
+    explicit UploadQueue(size_t capacity_) : capacity{capacity_} {}
+
+    // Returns false if the queue was closed, in which case the upload is dropped.
+    bool Push(size_t bytes, UploadFunc upload) {
+        std::unique_lock<std::mutex> lock{m};
+        notFull.wait(lock, [this] { return closed || pending.size() < capacity; });
+        if (closed) return false;
+        pending.push_back(Upload{bytes, std::move(upload)});
+        return true;
+    }
+
+    // Applies queued uploads in order until the next one would exceed byteBudget. The first one
+    // is always applied so oversized uploads still make progress. Returns the bytes uploaded.
+    size_t Drain(Target& target, size_t byteBudget) {
+        size_t uploaded = 0;
+        for (bool first = true;; first = false) {
+            Upload upload;
+            {
+                std::lock_guard<std::mutex> lock{m};
+                if (pending.empty() || (!first && uploaded + pending.front().bytes > byteBudget))
+                    break;
+                upload = std::move(pending.front());
+                pending.pop_front();
+            }
+            notFull.notify_one();
+            upload.apply(target);
+            uploaded += upload.bytes;
+        }
+        return uploaded;
+    }
+
+    // Drops everything still queued and releases blocked producers.
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock{m};
+            closed = true;
+            pending.clear();
+        }
+        notFull.notify_all();
+    }
+
+private:
+    struct Upload {
+        size_t bytes;
+        UploadFunc apply;
+    };
+
+    const size_t capacity;
+    std::mutex m;
+    std::condition_variable notFull;
+    std::deque<Upload> pending;
+    bool closed = false;
+};
+
+// Runs asset production jobs on worker threads and hands the resulting uploads to the render
+// thread through a bounded UploadQueue.
+template <typename Target>
+struct AssetLoader {
+    using UploadFunc = typename UploadQueue<Target>::UploadFunc;
+    struct Payload {
+        size_t bytes;
+        UploadFunc upload;
+    };
+
+    UploadQueue<Target> uploads;
+
+    AssetLoader(unsigned workerCount, size_t uploadCapacity) : uploads{uploadCapacity} {
+        for (auto i = 0u; i < workerCount; ++i) workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~AssetLoader() {
+        uploads.Close();
+        {
+            std::lock_guard<std::mutex> lock{m};
+            stopping = true;
+        }
+        jobReady.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    // Runs produce() on a worker thread and queues the upload it returns. The future becomes
+    // ready once the upload has been applied on the render thread. If produce or the upload
+    // throws, the exception is stored in the future and draining carries on with the next upload.
+    std::shared_future<void> Load(std::function<Payload()> produce) {
+        auto done = std::make_shared<std::promise<void>>();
+        auto res = done->get_future().share();
+        {
+            std::lock_guard<std::mutex> lock{m};
+            jobs.push_back([this, produce, done] {
+                try {
+                    const auto payload = produce();
+                    const auto upload = payload.upload;
+                    uploads.Push(payload.bytes, [upload, done](Target& target) {
+                        try {
+                            upload(target);
+                        } catch (...) {
+                            done->set_exception(std::current_exception());
+                            return;
+                        }
+                        done->set_value();
+                    });
+                } catch (...) {
+                    done->set_exception(std::current_exception());
+                }
+            });
+        }
+        jobReady.notify_one();
+        return res;
+    }
+
+private:
+    void WorkerLoop() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock{m};
+                jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex m;
+    std::condition_variable jobReady;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
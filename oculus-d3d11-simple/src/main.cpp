@@ -31,6 +31,10 @@ limitations under the License.
 #include <OVR_CAPI.h>  // Include the OculusVR SDK
 #include <Kernel/OVR_Math.h>
 
+#include "asset_loader.h"
+#include "pose_predictor.h"
+#include "scene_core.h"
+
 #include <comdef.h>
 #include <comip.h>
 
@@ -42,16 +46,24 @@ limitations under the License.
 
 #include <algorithm>
 #include <array>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 _COM_SMARTPTR_TYPEDEF(IDXGIFactory, __uuidof(IDXGIFactory));
 _COM_SMARTPTR_TYPEDEF(IDXGIAdapter, __uuidof(IDXGIAdapter));
+_COM_SMARTPTR_TYPEDEF(IDXGIDevice, __uuidof(IDXGIDevice));
 _COM_SMARTPTR_TYPEDEF(IDXGISwapChain, __uuidof(IDXGISwapChain));
 _COM_SMARTPTR_TYPEDEF(ID3D11Device, __uuidof(ID3D11Device));
 _COM_SMARTPTR_TYPEDEF(ID3D11DeviceContext, __uuidof(ID3D11DeviceContext));
+_COM_SMARTPTR_TYPEDEF(ID3D11CommandList, __uuidof(ID3D11CommandList));
 _COM_SMARTPTR_TYPEDEF(ID3D11Texture2D, __uuidof(ID3D11Texture2D));
 _COM_SMARTPTR_TYPEDEF(ID3D11RenderTargetView, __uuidof(ID3D11RenderTargetView));
 _COM_SMARTPTR_TYPEDEF(ID3D11ShaderResourceView, __uuidof(ID3D11ShaderResourceView));
@@ -69,77 +81,177 @@ _COM_SMARTPTR_TYPEDEF(ID3DBlob, __uuidof(ID3DBlob));
 using namespace OVR;
 using namespace std;
 
-struct EyeTarget {
+// Accounts for the memory of every texture and buffer the app creates, by category, and
+// enforces an optional budget. Each resource carries a tracker object as private data so its
+// bytes are released with the resource itself, however many references to it are held.
+struct ResourceRegistry {
+    enum Category {
+        RenderTarget,  // Includes depth buffers
+        Texture,
+        VertexBuffer,
+        IndexBuffer,
+        ConstantBuffer,
+        CategoryCount
+    };
+
+    size_t budget = SIZE_MAX;  // Bytes
+    // Called in order when an allocation would exceed the budget, with the bytes still needed.
+    // Evicting means releasing resources, accounting updates as they are destroyed. Empty
+    // entries are skipped, owners unregister by clearing theirs.
+    vector<function<void(size_t)>> evictionCallbacks;
+
+    ID3D11Texture2DPtr CreateTexture2D(ID3D11Device* device, const D3D11_TEXTURE2D_DESC& desc,
+                                       const D3D11_SUBRESOURCE_DATA* initialData,
+                                       Category category, const char* name);
+    ID3D11BufferPtr CreateBuffer(ID3D11Device* device, const D3D11_BUFFER_DESC& desc,
+                                 const D3D11_SUBRESOURCE_DATA* initialData, Category category,
+                                 const char* name);
+
+    size_t LiveBytes() const;
+    size_t PeakBytes() const;
+    string Report() const;
+
+    static size_t TextureBytes(const D3D11_TEXTURE2D_DESC& desc);
+
+private:
+    struct Allocation {
+        Category category;
+        size_t bytes;
+        string name;
+    };
+    struct Totals {
+        size_t live = 0, peak = 0;
+    };
+    struct Tracker;
+
+    void Reserve(size_t bytes);
+    void Track(ID3D11DeviceChild* resource, Category category, size_t bytes, const char* name);
+    void Release(uint64_t id);
+
+    mutable mutex m;
+    unordered_map<uint64_t, Allocation> allocations;
+    uint64_t nextId = 0;
+    array<Totals, CategoryCount> categoryTotals;
+    Totals totals;
+};
+
+// Color and depth target of a view, sized for its field of view and resolution scale.
+struct ViewTarget {
     ID3D11Texture2DPtr tex;
     ID3D11ShaderResourceViewPtr srv;
     ID3D11RenderTargetViewPtr rtv;
     ID3D11DepthStencilViewPtr dsv;
+    ID3D11BufferPtr viewConstants;
     ovrRecti viewport;
     Sizei size;
 
-    EyeTarget(ID3D11Device* device, Sizei size);
+    ViewTarget(ID3D11Device* device, ResourceRegistry& resources, Sizei size, const char* name);
+};
+
+// A camera following the tracked head. The eye views come first, in ovrEyeType order, further
+// views such as the spectator can render at a lower resolution or only every few frames.
+struct View {
+    ViewTarget target;
+    ovrFovPort fov;
+    Vector3f headToViewOffset;  // In head space
+    int updateInterval;         // Rendered every updateInterval frames
 };
 
+struct Model;
+
 struct DirectX11 {
     HINSTANCE hinst = nullptr;
     HWND window = nullptr;
     array<bool, 256> keys;
+    ResourceRegistry& resources;  // Outlives the device, see WinMain
     ID3D11DevicePtr device;
     ID3D11DeviceContextPtr context;
+    ID3D11DeviceContextPtr deferredContext;  // Records the scene, see FinishRecording
     IDXGISwapChainPtr swapChain;
     ID3D11RenderTargetViewPtr backBufferRT;
     ID3D11BufferPtr uniformBufferGen;
+    ID3D11RasterizerStatePtr rasterizerState;
+    ID3D11DepthStencilStatePtr depthStencilState;
     ID3D11SamplerStatePtr samplerState;
     ID3D11VertexShaderPtr vShader;
-    vector<unsigned char> uniformData;
-    unordered_map<string, int> uniformOffsets;
+    UniformBlock uniforms;
     ID3D11PixelShaderPtr pShader;
     ID3D11InputLayoutPtr inputLayout;
+    ID3D11ShaderResourceView* boundTexture = nullptr;  // Since the last ClearAndSetViewTarget
 
-    DirectX11(HINSTANCE hinst, const Recti& vp);
+    DirectX11(HINSTANCE hinst, const Recti& vp, ResourceRegistry& resources);
     ~DirectX11();
-    void ClearAndSetEyeTarget(const EyeTarget& eyeTarget);
+    void ClearAndSetViewTarget(const ViewTarget& viewTarget);
+    ID3D11CommandListPtr FinishRecording();
     void Render(ID3D11ShaderResourceView* texSrv, ID3D11Buffer* vertices, ID3D11Buffer* indices,
                 UINT stride, int count);
     bool IsAnyKeyPressed() const;
+    void Draw(const Model& model);
     void SetUniform(const char* name, int n, const float* v);
 };
 
-struct Model {
-    struct Color {
-        unsigned char r, g, b, a;
+// Desktop window showing a view's target at its native size, so operators can watch the
+// spectator view or point capture and streaming tools at it.
+struct MirrorWindow {
+    HINSTANCE hinst = nullptr;
+    HWND window = nullptr;
+    IDXGISwapChainPtr swapChain;
+    ID3D11Texture2DPtr backBuffer;
 
-        Color(unsigned char r_ = 0, unsigned char g_ = 0, unsigned char b_ = 0,
-              unsigned char a_ = 0xff)
-            : r{r_}, g{g_}, b{b_}, a{a_} {}
-    };
-    struct Vertex {
-        Vector3f pos;
-        Color c;
-        float u, v;
-    };
+    MirrorWindow(DirectX11& dx11, const ViewTarget& source);
+    ~MirrorWindow();
+    // Copies source to the window without waiting for vsync, so the HMD is never held up.
+    void Present(ID3D11DeviceContext* context, const ViewTarget& source);
+};
 
+struct Model : Mesh {
     Vector3f pos;
-    vector<Vertex> vertices;
-    vector<uint16_t> indices;
     ID3D11BufferPtr vertexBuffer;
     ID3D11BufferPtr indexBuffer;
     ID3D11ShaderResourceViewPtr textureSrv;
+    BoundingBox bounds;
 
     Model(Vector3f pos_, ID3D11ShaderResourceView* texSrv) : pos{pos_}, textureSrv{texSrv} {}
 
-    Matrix4f GetMatrix() { return Matrix4f::Translation(pos); }
-    void AllocateBuffers(ID3D11Device* device);
-    void Model::AddSolidColorBox(float x1, float y1, float z1, float x2, float y2, float z2,
-                                 Color c);
+    Matrix4f GetMatrix() const { return Matrix4f::Translation(pos); }
+    bool IsUploaded() const { return vertexBuffer.GetInterfacePtr() != nullptr; }
+    uintptr_t SortKey() const { return reinterpret_cast<uintptr_t>(textureSrv.GetInterfacePtr()); }
+    void AllocateBuffers(ID3D11Device* device, ResourceRegistry& resources);
 };
 
 struct Scene {
+    // An uploaded texture and the models drawn with it. The pixels are kept so the texture can
+    // be restored after it has been evicted.
+    struct LoadedTexture {
+        shared_ptr<const TextureData> data;
+        vector<Model*> users;
+        ID3D11ShaderResourceViewPtr srv;  // Null while evicted
+    };
+
     vector<unique_ptr<Model>> models;
+    ID3D11ShaderResourceViewPtr placeholderTexture;
+    vector<LoadedTexture> textures;     // In upload order
+    vector<shared_future<void>> loads;  // One per texture and model, ready once uploaded
+    DrawList<Model> drawList;           // Models visible in any view of the current frame
+
+    Scene(DirectX11& dx11, AssetLoader<DirectX11>& loader);
+    ~Scene();
 
-    Scene(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+    // Builds the frame's draw list once for all views, view i being culled against frustums[i].
+    void Cull(const Frustum* frustums, size_t viewCount);
+    void Render(DirectX11& dx11, size_t view) const;
+    // Re-creates the oldest evicted texture, if the GPU memory budget has room for it again.
+    // At most one per call, to bound the per frame upload cost.
+    void RestoreTextures(DirectX11& dx11);
+
+private:
+    ResourceRegistry& resources;
+    size_t evictionCallback;  // Index in resources.evictionCallbacks
 
-    void Render(DirectX11& dx11, const Matrix4f& view, const Matrix4f& proj);
+    // Eviction policy for the GPU memory budget: returns the oldest resident textures' models to
+    // the placeholder texture until bytes have been freed or no textures are left, see
+    // RestoreTextures for bringing them back.
+    void EvictTextures(size_t bytes);
 };
 
 void throwOnError(ovrBool res, ovrHmd hmd = nullptr) {
@@ -168,6 +280,26 @@ scope_exit<Func> on_scope_exit(Func f) {
 
 //-------------------------------------------------------------------------------------
 int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR /*args*/, int) {
+    // '--record-poses <trace>' saves every tracker sample, '--pose-harness <trace>' replays such
+    // a trace through the pose predictor offline and writes <trace>.report.csv, no HMD needed.
+    // '--gpu-budget-mb <n>' caps the memory of the textures and buffers the app creates.
+    // '--spectator' adds a low resolution mirror view for operators in a window, see below.
+    const vector<string> args(__argv + 1, __argv + __argc);
+    auto argValue = [&args](const char* name) {
+        const auto it = find(begin(args), end(args), name);
+        return it != end(args) && next(it) != end(args) ? *next(it) : string{};
+    };
+    if (!argValue("--pose-harness").empty()) return RunPoseHarness(argValue("--pose-harness"));
+    ofstream poseTrace;
+    if (!argValue("--record-poses").empty()) poseTrace.open(argValue("--record-poses"));
+
+    // Accounts for every texture and buffer. The SDK keeps references to the device and the eye
+    // textures until the HMD is destroyed or the SDK shut down, so the registry has to outlive
+    // both.
+    ResourceRegistry resources;
+    if (!argValue("--gpu-budget-mb").empty())
+        resources.budget = static_cast<size_t>(stoull(argValue("--gpu-budget-mb"))) << 20;
+
     // Initialize the OVR SDK
     throwOnError(ovr_Initialize());
     auto ovr = on_scope_exit([] { ovr_Shutdown(); });
@@ -192,7 +324,7 @@ int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR /*args*/, int) {
     unique_ptr<const ovrHmdDesc, decltype(hmdDestroy)> hmd{hmdCreate(), hmdDestroy};
 
     // Create the Direct3D11 device and window
-    DirectX11 dx11{hinst, Recti{hmd->WindowsPos, hmd->Resolution}};
+    DirectX11 dx11{hinst, Recti{hmd->WindowsPos, hmd->Resolution}, resources};
 
     // Attach HMD to window and initialize tracking
     throwOnError(ovrHmd_AttachToWindow(hmd.get(), dx11.window, nullptr, nullptr), hmd.get());
@@ -203,13 +335,6 @@ int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR /*args*/, int) {
                                           0),
                  hmd.get());
 
-    // Create the eye render targets.
-    const EyeTarget eyeTargets[] = {
-        {dx11.device,
-         ovrHmd_GetFovTextureSize(hmd.get(), ovrEye_Left, hmd->DefaultEyeFov[ovrEye_Left], 1.0f)},
-        {dx11.device, ovrHmd_GetFovTextureSize(hmd.get(), ovrEye_Right,
-                                               hmd->DefaultEyeFov[ovrEye_Right], 1.0f)}};
-
     // Configure SDK rendering
     auto eyeRenderDesc = [&dx11, &hmd] {
         ovrD3D11Config d3d11cfg{};
@@ -231,15 +356,78 @@ int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR /*args*/, int) {
         return res;
     }();
 
+    // Create the views, the two eyes and optionally the spectator
+    vector<View> views;
+    unique_ptr<MirrorWindow> spectatorWindow;
+    const char* eyeNames[] = {"Left eye", "Right eye"};
+    for (int eye = 0; eye < 2; ++eye) {
+        const auto fov = eyeRenderDesc[eye].Fov;
+        const ViewTarget target{
+            dx11.device, dx11.resources,
+            ovrHmd_GetFovTextureSize(hmd.get(), ovrEyeType(eye), fov, 1.0f), eyeNames[eye]};
+        views.push_back(View{target, fov, Vector3f(eyeRenderDesc[eye].HmdToEyeViewOffset), 1});
+    }
+    if (find(begin(args), end(args), "--spectator") != end(args)) {
+        // Mirrors the player's view from between the eyes, covering both eyes' fields of view
+        // at half the resolution and half the frame rate. It shares the frame's culling with
+        // the eyes, so it only adds its own draws. It is shown in a desktop window of its own.
+        ovrFovPort fov = hmd->DefaultEyeFov[ovrEye_Left];
+        const auto& rightFov = hmd->DefaultEyeFov[ovrEye_Right];
+        fov.UpTan = max(fov.UpTan, rightFov.UpTan);
+        fov.DownTan = max(fov.DownTan, rightFov.DownTan);
+        fov.LeftTan = max(fov.LeftTan, rightFov.LeftTan);
+        fov.RightTan = max(fov.RightTan, rightFov.RightTan);
+        const ViewTarget target{dx11.device, dx11.resources,
+                                ovrHmd_GetFovTextureSize(hmd.get(), ovrEye_Left, fov, 0.5f),
+                                "Spectator"};
+        views.push_back(View{target, fov, Vector3f(0, 0, 0), 2});
+        spectatorWindow = make_unique<MirrorWindow>(dx11, target);
+    }
+
+    // Projection for a view, with its field of view scaled by fovScale (note near Z to reduce
+    // eye strain)
+    auto viewProjection = [](ovrFovPort fov, float fovScale) -> Matrix4f {
+        fov.UpTan *= fovScale;
+        fov.DownTan *= fovScale;
+        fov.LeftTan *= fovScale;
+        fov.RightTan *= fovScale;
+        return ovrMatrix4f_Projection(fov, 0.2f, 1000.0f, true);
+    };
+    auto viewPose = [](const View& view, const PoseSample& head) {
+        ovrPosef res;
+        res.Orientation = head.orientation;
+        res.Position = head.position + head.orientation.Rotate(view.headToViewOffset);
+        return res;
+    };
+
+    // Generate textures and geometry in the background, the room fills in as uploads complete
+    const auto hardwareThreads = thread::hardware_concurrency();
+    AssetLoader<DirectX11> loader{hardwareThreads > 1 ? hardwareThreads - 1 : 1, 16};
+    const size_t uploadBytesPerFrame = 1 << 20;
+
     // Create the room models
-    Scene roomScene{dx11.device, dx11.context};
+    Scene roomScene{dx11, loader};
 
     float yaw = 3.141592f;            // Horizontal rotation of the player
     Vector3f pos{0.0f, 1.6f, -5.0f};  // Position of player
 
+    // Head tracking is sampled without SDK prediction, the predictor extrapolates to display time
+    PosePredictor posePredictor;
+    auto sampleHeadPose = [&hmd, &posePredictor, &poseTrace] {
+        const auto state = ovrHmd_GetTrackingState(hmd.get(), ovr_GetTimeInSeconds());
+        const PoseSample sample{state.HeadPose.TimeInSeconds,
+                                Quatf(state.HeadPose.ThePose.Orientation),
+                                Vector3f(state.HeadPose.ThePose.Position)};
+        posePredictor.AddSample(sample);
+        if (poseTrace.is_open()) poseTrace << sample << '\n';
+    };
+
     // MAIN LOOP
     // =========
     int appClock = 0;
+    bool reportKeyDown = false;
+    vector<size_t> activeViews;  // Indices of the views rendered this frame
+    vector<Frustum> frustums;    // Of the active views, widened for culling
 
     while (!(dx11.keys['Q'] && dx11.keys[VK_CONTROL]) && !dx11.keys[VK_ESCAPE]) {
         ++appClock;
@@ -251,17 +439,24 @@ int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR /*args*/, int) {
         }
 
         const float speed = 1.0f;  // Can adjust the movement speed.
-        ovrVector3f useHmdToEyeViewOffset[2] = {eyeRenderDesc[0].HmdToEyeViewOffset,
-                                                eyeRenderDesc[1].HmdToEyeViewOffset};
 
-        ovrHmd_BeginFrame(hmd.get(), 0);
+        const ovrFrameTiming frameTiming = ovrHmd_BeginFrame(hmd.get(), 0);
+        sampleHeadPose();
 
         // Recenter the Rift by pressing 'R'
-        if (dx11.keys['R']) ovrHmd_RecenterPose(hmd.get());
+        if (dx11.keys['R']) {
+            ovrHmd_RecenterPose(hmd.get());
+            posePredictor.Reset();
+            sampleHeadPose();
+        }
 
         // Dismiss the Health and Safety message by pressing any key
         if (dx11.IsAnyKeyPressed()) ovrHmd_DismissHSWDisplay(hmd.get());
 
+        // Dump GPU memory use to the debug output by pressing 'M'
+        if (dx11.keys['M'] && !reportKeyDown) OutputDebugStringA(dx11.resources.Report().c_str());
+        reportKeyDown = dx11.keys['M'];
+
         // Keyboard inputs to adjust player orientation
         if (dx11.keys[VK_LEFT]) yaw += 0.02f;
         if (dx11.keys[VK_RIGHT]) yaw -= 0.02f;
@@ -277,49 +472,70 @@ int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR /*args*/, int) {
             pos += Matrix4f::RotationY(yaw).Transform(Vector3f(-speed * 0.05f, 0, 0));
         pos.y = ovrHmd_GetFloat(hmd.get(), OVR_KEY_EYE_HEIGHT, pos.y);
 
+        // Hand over as much finished content as the per frame upload budget allows
+        loader.uploads.Drain(dx11, uploadBytesPerFrame);
+        roomScene.RestoreTextures(dx11);
+
         // Animate the cube
         roomScene.models[0]->pos =
             Vector3f{9 * sin(0.01f * appClock), 3, 9 * cos(0.01f * appClock)};
 
-        // Get both eye poses simultaneously, with IPD offset already included.
-        ovrPosef eyePoses[2] = {};
-        ovrHmd_GetEyePoses(hmd.get(), 0, useHmdToEyeViewOffset, eyePoses, nullptr);
-
-        // Render the two undistorted eye views into their render buffers.
-        for (int eye = 0; eye < 2; ++eye) {
-            const auto& useTarget = eyeTargets[eye];
-            const auto& useEyePose = eyePoses[eye];
-
-            dx11.ClearAndSetEyeTarget(useTarget);
-
-            // Get view and projection matrices (note near Z to reduce eye strain)
-            const Matrix4f rollPitchYaw = Matrix4f::RotationY(yaw);
-            const Matrix4f finalRollPitchYaw = rollPitchYaw * Matrix4f(useEyePose.Orientation);
-            const Vector3f finalUp = finalRollPitchYaw.Transform(Vector3f{0, 1, 0});
-            const Vector3f finalForward = finalRollPitchYaw.Transform(Vector3f{0, 0, -1});
-            const Vector3f shiftedEyePos = pos + rollPitchYaw.Transform(useEyePose.Position);
-
-            const Matrix4f view =
-                Matrix4f::LookAtRH(shiftedEyePos, shiftedEyePos + finalForward, finalUp);
-            const Matrix4f proj =
-                ovrMatrix4f_Projection(eyeRenderDesc[eye].Fov, 0.2f, 1000.0f, true);
+        // Shared per frame work: cull and sort the scene once for every view due this frame.
+        // The poses are only latched after recording, so the frustums come from an earlier
+        // prediction and are widened to keep models the head turns towards in the meantime.
+        const PoseSample cullHead = posePredictor.Predict(frameTiming.ScanoutMidpointSeconds);
+        activeViews.clear();
+        frustums.clear();
+        for (size_t v = 0; v < views.size(); ++v) {
+            if (appClock % views[v].updateInterval != 0) continue;
+            const auto pose = viewPose(views[v], cullHead);
+            const Matrix4f view = EyeViewMatrix(yaw, pos, pose.Orientation, pose.Position);
+            frustums.push_back(Frustum{viewProjection(views[v].fov, 1.1f) * view});
+            activeViews.push_back(v);
+        }
+        roomScene.Cull(frustums.data(), frustums.size());
 
-            // Render the scene
-            roomScene.Render(dx11, view, proj);
+        // Record the undistorted views. View and projection are read from each view's constant
+        // buffer, which is only written once the poses have been latched below.
+        for (size_t i = 0; i < activeViews.size(); ++i) {
+            dx11.ClearAndSetViewTarget(views[activeViews[i]].target);
+            roomScene.Render(dx11, i);
         }
+        const ID3D11CommandListPtr commandList = dx11.FinishRecording();
+
+        // Late latch: sample the tracker as late as possible and predict to mid scanout
+        sampleHeadPose();
+        const PoseSample head = posePredictor.Predict(frameTiming.ScanoutMidpointSeconds);
+        for (auto v : activeViews) {
+            const auto pose = viewPose(views[v], head);
+            const Matrix4f view = EyeViewMatrix(yaw, pos, pose.Orientation, pose.Position);
+            const Matrix4f proj = viewProjection(views[v].fov, 1.0f);
+
+            const ViewConstants constants{proj.Transposed(), view.Transposed()};
+            dx11.context->UpdateSubresource(views[v].target.viewConstants, 0, nullptr, &constants,
+                                            0, 0);
+        }
+        dx11.context->ExecuteCommandList(commandList, FALSE);
 
         // Do distortion rendering, Present and flush/sync
-        [&eyeTargets, &eyePoses, &hmd] {
+        [&views, &viewPose, &head, &hmd] {
+            ovrPosef eyePoses[2];
             ovrD3D11Texture eyeTexture[2];
             for (int eye = 0; eye < 2; ++eye) {
+                const auto& target = views[eye].target;
+                eyePoses[eye] = viewPose(views[eye], head);
                 eyeTexture[eye].D3D11.Header.API = ovrRenderAPI_D3D11;
-                eyeTexture[eye].D3D11.Header.TextureSize = eyeTargets[eye].size;
-                eyeTexture[eye].D3D11.Header.RenderViewport = eyeTargets[eye].viewport;
-                eyeTexture[eye].D3D11.pTexture = eyeTargets[eye].tex;
-                eyeTexture[eye].D3D11.pSRView = eyeTargets[eye].srv;
+                eyeTexture[eye].D3D11.Header.TextureSize = target.size;
+                eyeTexture[eye].D3D11.Header.RenderViewport = target.viewport;
+                eyeTexture[eye].D3D11.pTexture = target.tex;
+                eyeTexture[eye].D3D11.pSRView = target.srv;
             }
             ovrHmd_EndFrame(hmd.get(), eyePoses, &eyeTexture[0].Texture);
         }();
+
+        // The spectator is always the last view
+        if (spectatorWindow && activeViews.back() == views.size() - 1)
+            spectatorWindow->Present(dx11.context, views.back().target);
     }
 
     return 0;
@@ -333,22 +549,205 @@ void ThrowOnFailure(HRESULT hr) {
     }
 }
 
-EyeTarget::EyeTarget(ID3D11Device* device, Sizei requestedSize) {
+// {02729FE1-49F7-451E-989D-C88456A46338}
+const GUID ResourceTrackerGuid = {
+    0x2729fe1, 0x49f7, 0x451e, {0x98, 0x9d, 0xc8, 0x84, 0x56, 0xa4, 0x63, 0x38}};
+
+// Attached to a resource as private data, released by D3D when the resource is destroyed.
+struct ResourceRegistry::Tracker : IUnknown {
+    Tracker(ResourceRegistry& registry_, uint64_t id_) : registry(registry_), id{id_} {}
+    ~Tracker() { registry.Release(id); }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+        if (riid != __uuidof(IUnknown)) {
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        AddRef();
+        *object = this;
+        return S_OK;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override {
+        return static_cast<ULONG>(InterlockedIncrement(&refCount));
+    }
+    ULONG STDMETHODCALLTYPE Release() override {
+        const auto res = InterlockedDecrement(&refCount);
+        if (res == 0) delete this;
+        return static_cast<ULONG>(res);
+    }
+
+private:
+    ResourceRegistry& registry;
+    const uint64_t id;
+    LONG refCount = 1;
+};
+
+ID3D11Texture2DPtr ResourceRegistry::CreateTexture2D(ID3D11Device* device,
+                                                     const D3D11_TEXTURE2D_DESC& desc,
+                                                     const D3D11_SUBRESOURCE_DATA* initialData,
+                                                     Category category, const char* name) {
+    const auto bytes = TextureBytes(desc);
+    Reserve(bytes);
+    ID3D11Texture2DPtr tex;
+    ThrowOnFailure(device->CreateTexture2D(&desc, initialData, &tex));
+    Track(tex, category, bytes, name);
+    return tex;
+}
+
+ID3D11BufferPtr ResourceRegistry::CreateBuffer(ID3D11Device* device, const D3D11_BUFFER_DESC& desc,
+                                               const D3D11_SUBRESOURCE_DATA* initialData,
+                                               Category category, const char* name) {
+    Reserve(desc.ByteWidth);
+    ID3D11BufferPtr buffer;
+    ThrowOnFailure(device->CreateBuffer(&desc, initialData, &buffer));
+    Track(buffer, category, desc.ByteWidth, name);
+    return buffer;
+}
+
+size_t ResourceRegistry::LiveBytes() const {
+    lock_guard<mutex> lock{m};
+    return totals.live;
+}
+
+size_t ResourceRegistry::PeakBytes() const {
+    lock_guard<mutex> lock{m};
+    return totals.peak;
+}
+
+string ResourceRegistry::Report() const {
+    const char* categoryNames[] = {"render target", "texture", "vertex buffer", "index buffer",
+                                   "constant buffer"};
+    auto megabytes = [](size_t bytes) { return to_string(bytes / (1024.0 * 1024.0)) + " MB"; };
+
+    lock_guard<mutex> lock{m};
+    string res = "GPU resources: " + megabytes(totals.live) + " live, " +
+                 megabytes(totals.peak) + " peak, budget " +
+                 (budget == SIZE_MAX ? string{"unlimited"} : megabytes(budget)) + "\n";
+    for (int c = 0; c < CategoryCount; ++c)
+        res += string{"  "} + categoryNames[c] + ": " + megabytes(categoryTotals[c].live) +
+               " live, " + megabytes(categoryTotals[c].peak) + " peak\n";
+
+    vector<const Allocation*> sorted;
+    for (const auto& allocation : allocations) sorted.push_back(&allocation.second);
+    sort(begin(sorted), end(sorted),
+         [](const Allocation* a, const Allocation* b) { return a->bytes > b->bytes; });
+    for (auto allocation : sorted)
+        res += "  " + to_string(allocation->bytes) + " bytes, " +
+               categoryNames[allocation->category] + ", " + allocation->name + "\n";
+    return res;
+}
+
+size_t ResourceRegistry::TextureBytes(const D3D11_TEXTURE2D_DESC& desc) {
+    // Bytes per block and block size in texels, 1 for uncompressed formats
+    const auto format = [](DXGI_FORMAT f) -> pair<size_t, UINT> {
+        switch (f) {
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+                return {16, 1};
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+                return {8, 1};
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            case DXGI_FORMAT_R10G10B10A2_UNORM:
+            case DXGI_FORMAT_R11G11B10_FLOAT:
+            case DXGI_FORMAT_R32_FLOAT:
+            case DXGI_FORMAT_D32_FLOAT:
+            case DXGI_FORMAT_D24_UNORM_S8_UINT:
+                return {4, 1};
+            case DXGI_FORMAT_R16_FLOAT:
+            case DXGI_FORMAT_D16_UNORM:
+                return {2, 1};
+            case DXGI_FORMAT_R8_UNORM:
+                return {1, 1};
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+                return {8, 4};
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+                return {16, 4};
+            default:
+                throw runtime_error{"Unknown texture format size"};
+        }
+    }(desc.Format);
+
+    // MipLevels 0 means a full mip chain
+    auto mipLevels = desc.MipLevels;
+    if (mipLevels == 0)
+        for (auto size = max(desc.Width, desc.Height); size > 0; size >>= 1) ++mipLevels;
+
+    size_t bytes = 0;
+    for (auto level = 0u; level < mipLevels; ++level) {
+        const auto w = max(desc.Width >> level, 1u), h = max(desc.Height >> level, 1u);
+        const auto blocksW = (w + format.second - 1) / format.second;
+        const auto blocksH = (h + format.second - 1) / format.second;
+        bytes += blocksW * blocksH * format.first;
+    }
+    return bytes * desc.ArraySize * desc.SampleDesc.Count;
+}
+
+void ResourceRegistry::Reserve(size_t bytes) {
+    // Callbacks release resources, which re-enters the registry, so the lock is not held here
+    for (const auto& evict : evictionCallbacks) {
+        if (!evict) continue;
+        const auto liveBytes = LiveBytes();
+        if (liveBytes + bytes <= budget) return;
+        evict(liveBytes + bytes - budget);
+    }
+    if (LiveBytes() + bytes > budget) throw runtime_error{"GPU memory budget exceeded"};
+}
+
+void ResourceRegistry::Track(ID3D11DeviceChild* resource, Category category, size_t bytes,
+                             const char* name) {
+    uint64_t id;
+    {
+        lock_guard<mutex> lock{m};
+        id = nextId++;
+        allocations[id] = Allocation{category, bytes, name};
+        auto& categoryTotal = categoryTotals[category];
+        categoryTotal.live += bytes;
+        categoryTotal.peak = max(categoryTotal.peak, categoryTotal.live);
+        totals.live += bytes;
+        totals.peak = max(totals.peak, totals.live);
+    }
+    IUnknownPtr tracker{new Tracker{*this, id}, false};
+    ThrowOnFailure(resource->SetPrivateDataInterface(ResourceTrackerGuid, tracker));
+}
+
+void ResourceRegistry::Release(uint64_t id) {
+    lock_guard<mutex> lock{m};
+    const auto it = allocations.find(id);
+    if (it == end(allocations)) return;
+    categoryTotals[it->second.category].live -= it->second.bytes;
+    totals.live -= it->second.bytes;
+    allocations.erase(it);
+}
+
+ViewTarget::ViewTarget(ID3D11Device* device, ResourceRegistry& resources, Sizei requestedSize,
+                       const char* name) {
     CD3D11_TEXTURE2D_DESC texDesc(DXGI_FORMAT_R8G8B8A8_UNORM, requestedSize.w, requestedSize.h);
     texDesc.MipLevels = 1;
     texDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
-    device->CreateTexture2D(&texDesc, nullptr, &tex);
-    device->CreateShaderResourceView(tex, nullptr, &srv);
-    device->CreateRenderTargetView(tex, nullptr, &rtv);
+    tex = resources.CreateTexture2D(device, texDesc, nullptr, ResourceRegistry::RenderTarget,
+                                    (string{name} + " color").c_str());
+    ThrowOnFailure(device->CreateShaderResourceView(tex, nullptr, &srv));
+    ThrowOnFailure(device->CreateRenderTargetView(tex, nullptr, &rtv));
     tex->GetDesc(&texDesc);  // Get the actual size in case it was adjusted on create
     size = Sizei(texDesc.Width, texDesc.Height);
 
     CD3D11_TEXTURE2D_DESC dsDesc{DXGI_FORMAT_D32_FLOAT, texDesc.Width, texDesc.Height};
     dsDesc.MipLevels = 1;
     dsDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-    ID3D11Texture2DPtr dsTex;
-    device->CreateTexture2D(&dsDesc, nullptr, &dsTex);
-    device->CreateDepthStencilView(dsTex, nullptr, &dsv);
+    const auto dsTex = resources.CreateTexture2D(device, dsDesc, nullptr,
+                                                 ResourceRegistry::RenderTarget,
+                                                 (string{name} + " depth").c_str());
+    ThrowOnFailure(device->CreateDepthStencilView(dsTex, nullptr, &dsv));
+
+    CD3D11_BUFFER_DESC cbDesc{sizeof(ViewConstants), D3D11_BIND_CONSTANT_BUFFER};
+    viewConstants =
+        resources.CreateBuffer(device, cbDesc, nullptr, ResourceRegistry::ConstantBuffer,
+                               (string{name} + " view constants").c_str());
 
     viewport.Pos = Vector2i{0, 0};
     viewport.Size = Sizei(texDesc.Width, texDesc.Height);
@@ -384,7 +783,8 @@ LRESULT CALLBACK SystemWindowProc(HWND arg_hwnd, UINT msg, WPARAM wp, LPARAM lp)
     return DefWindowProc(arg_hwnd, msg, wp, lp);
 }
 
-DirectX11::DirectX11(HINSTANCE hinst_, const Recti& vp) : hinst{hinst_} {
+DirectX11::DirectX11(HINSTANCE hinst_, const Recti& vp, ResourceRegistry& resources_)
+    : hinst{hinst_}, resources(resources_) {
     fill(begin(keys), end(keys), false);
 
     window = [this, vp] {
@@ -435,6 +835,10 @@ DirectX11::DirectX11(HINSTANCE hinst_, const Recti& vp) : hinst{hinst_} {
             creationFlags, nullptr, 0, D3D11_SDK_VERSION, &scDesc, sc, dev, nullptr, ctx));
     }(window, &swapChain, &device, &context);
 
+    // The scene is recorded into a command list so per view constants can be written after
+    // recording, as late as possible before submission.
+    ThrowOnFailure(device->CreateDeferredContext(0, &deferredContext));
+
     [](IDXGISwapChain* sc, ID3D11Device* dev, ID3D11RenderTargetView** backBufferRtv) {
         ID3D11Texture2DPtr backBuffer;
         ThrowOnFailure(
@@ -442,25 +846,22 @@ DirectX11::DirectX11(HINSTANCE hinst_, const Recti& vp) : hinst{hinst_} {
         ThrowOnFailure(dev->CreateRenderTargetView(backBuffer, nullptr, backBufferRtv));
     }(swapChain, device, &backBufferRT);
 
-    [](ID3D11Device* dev, ID3D11Buffer** uniformBuffer) {
+    uniformBufferGen = [this] {
         CD3D11_BUFFER_DESC desc{2000u, D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC,
                                 D3D11_CPU_ACCESS_WRITE};
-        ThrowOnFailure(dev->CreateBuffer(&desc, nullptr, uniformBuffer));
-    }(device, &uniformBufferGen);
+        return resources.CreateBuffer(device, desc, nullptr, ResourceRegistry::ConstantBuffer,
+                                      "Per draw uniforms");
+    }();
 
-    [](ID3D11Device* dev, ID3D11DeviceContext* ctx) {
+    [](ID3D11Device* dev, ID3D11RasterizerState** rs) {
         CD3D11_RASTERIZER_DESC desc{D3D11_DEFAULT};
-        ID3D11RasterizerStatePtr rasterizerState;
-        ThrowOnFailure(dev->CreateRasterizerState(&desc, &rasterizerState));
-        ctx->RSSetState(rasterizerState);
-    }(device, context);
+        ThrowOnFailure(dev->CreateRasterizerState(&desc, rs));
+    }(device, &rasterizerState);
 
-    [](ID3D11Device* dev, ID3D11DeviceContext* ctx) {
+    [](ID3D11Device* dev, ID3D11DepthStencilState** dss) {
         CD3D11_DEPTH_STENCIL_DESC desc{D3D11_DEFAULT};
-        ID3D11DepthStencilStatePtr depthStencilState;
-        ThrowOnFailure(dev->CreateDepthStencilState(&desc, &depthStencilState));
-        ctx->OMSetDepthStencilState(depthStencilState, 0);
-    }(device, context);
+        ThrowOnFailure(dev->CreateDepthStencilState(&desc, dss));
+    }(device, &depthStencilState);
 
     [](ID3D11Device* dev, ID3D11SamplerState** ss) {
         CD3D11_SAMPLER_DESC desc{D3D11_DEFAULT};
@@ -481,7 +882,8 @@ DirectX11::DirectX11(HINSTANCE hinst_, const Recti& vp) : hinst{hinst_} {
         };
 
         const char* VertexShaderSrc = R"(
-        float4x4 Proj, View, World;
+        cbuffer ViewConstants : register(b1) { float4x4 Proj, View; };
+        float4x4 World;
         void main(in float4 Position : POSITION, in float4 Color : COLOR0, in float2 TexCoord : TEXCOORD0, 
                   out float4 oPosition : SV_Position, out float4 oColor : COLOR0, out float2 oTexCoord : TEXCOORD0, 
                   out float3 oWorldPos : TEXCOORD1)
@@ -503,7 +905,7 @@ DirectX11::DirectX11(HINSTANCE hinst_, const Recti& vp) : hinst{hinst_} {
         ID3D11ShaderReflectionPtr ref;
         D3DReflect(blobData->GetBufferPointer(), blobData->GetBufferSize(),
                    __uuidof(ID3D11ShaderReflection), reinterpret_cast<void**>(&ref));
-        ID3D11ShaderReflectionConstantBuffer* buf = ref->GetConstantBufferByIndex(0);
+        ID3D11ShaderReflectionConstantBuffer* buf = ref->GetConstantBufferByName("$Globals");
         D3D11_SHADER_BUFFER_DESC bufd{};
         ThrowOnFailure(buf->GetDesc(&bufd));
 
@@ -511,9 +913,9 @@ DirectX11::DirectX11(HINSTANCE hinst_, const Recti& vp) : hinst{hinst_} {
             ID3D11ShaderReflectionVariable* var = buf->GetVariableByIndex(i);
             D3D11_SHADER_VARIABLE_DESC vd{};
             var->GetDesc(&vd);
-            uniformOffsets[vd.Name] = vd.StartOffset;
+            uniforms.offsets[vd.Name] = vd.StartOffset;
         }
-        uniformData.resize(bufd.Size);
+        uniforms.data.resize(bufd.Size);
 
         device->CreateInputLayout(desc, 3, blobData->GetBufferPointer(), blobData->GetBufferSize(),
                                   il);
@@ -548,251 +950,306 @@ DirectX11::~DirectX11() {
     UnregisterClassW(L"OVRAppWindow", hinst);
 }
 
-void DirectX11::ClearAndSetEyeTarget(const EyeTarget& eyeTarget) {
+MirrorWindow::MirrorWindow(DirectX11& dx11, const ViewTarget& source) : hinst{dx11.hinst} {
+    // A plain window class of its own, SystemWindowProc would capture the mouse for the HMD
+    // window and pass key presses to the player
+    const auto className = L"OVRMirrorWindow";
+    WNDCLASSW wc{};
+    wc.lpszClassName = className;
+    wc.lpfnWndProc = DefWindowProcW;
+    wc.hInstance = hinst;
+    wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+    RegisterClassW(&wc);
+
+    const DWORD wsStyle = WS_OVERLAPPEDWINDOW;
+    RECT winSize{0, 0, source.size.w, source.size.h};
+    AdjustWindowRect(&winSize, wsStyle, false);
+    window = CreateWindowW(className, L"OculusRoomTiny Spectator", wsStyle, CW_USEDEFAULT,
+                           CW_USEDEFAULT, winSize.right - winSize.left,
+                           winSize.bottom - winSize.top, nullptr, nullptr, hinst, nullptr);
+    if (!window) throw runtime_error{"Failed to create spectator window"};
+    ShowWindow(window, SW_SHOWNOACTIVATE);  // Keyboard focus stays with the HMD window
+
+    IDXGIDevicePtr dxgiDevice;
+    ThrowOnFailure(dx11.device->QueryInterface(__uuidof(IDXGIDevice),
+                                               reinterpret_cast<void**>(&dxgiDevice)));
+    IDXGIAdapterPtr adapter;
+    ThrowOnFailure(dxgiDevice->GetAdapter(&adapter));
+    IDXGIFactoryPtr factory;
+    ThrowOnFailure(adapter->GetParent(__uuidof(IDXGIFactory), reinterpret_cast<void**>(&factory)));
+
+    // Same size and format as the source, so presenting is a single copy
+    DXGI_SWAP_CHAIN_DESC scDesc{};
+    scDesc.BufferCount = 1;
+    scDesc.BufferDesc.Width = source.size.w;
+    scDesc.BufferDesc.Height = source.size.h;
+    scDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    scDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    scDesc.OutputWindow = window;
+    scDesc.SampleDesc.Count = 1;
+    scDesc.Windowed = TRUE;
+    scDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+    ThrowOnFailure(factory->CreateSwapChain(dx11.device, &scDesc, &swapChain));
+    ThrowOnFailure(swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D),
+                                        reinterpret_cast<void**>(&backBuffer)));
+}
+
+MirrorWindow::~MirrorWindow() {
+    // The swap chain goes before the window it presents to
+    backBuffer = nullptr;
+    swapChain = nullptr;
+    DestroyWindow(window);
+    UnregisterClassW(L"OVRMirrorWindow", hinst);
+}
+
+void MirrorWindow::Present(ID3D11DeviceContext* context, const ViewTarget& source) {
+    context->CopyResource(backBuffer, source.tex);
+    swapChain->Present(0, 0);  // Fails harmlessly once the operator has closed the window
+}
+
+void DirectX11::ClearAndSetViewTarget(const ViewTarget& viewTarget) {
     const float black[] = {0.f, 0.f, 0.f, 1.f};
-    ID3D11RenderTargetView* rtvs[] = {eyeTarget.rtv};
-    context->OMSetRenderTargets(1, rtvs, eyeTarget.dsv);
-    context->ClearRenderTargetView(eyeTarget.rtv, black);
-    context->ClearDepthStencilView(eyeTarget.dsv, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1, 0);
+    ID3D11RenderTargetView* rtvs[] = {viewTarget.rtv};
+    deferredContext->OMSetRenderTargets(1, rtvs, viewTarget.dsv);
+    deferredContext->ClearRenderTargetView(viewTarget.rtv, black);
+    deferredContext->ClearDepthStencilView(viewTarget.dsv,
+                                           D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1, 0);
+    deferredContext->RSSetState(rasterizerState);
+    deferredContext->OMSetDepthStencilState(depthStencilState, 0);
+    ID3D11Buffer* vsConstantBuffers[] = {viewTarget.viewConstants};
+    deferredContext->VSSetConstantBuffers(1, 1, vsConstantBuffers);
     D3D11_VIEWPORT d3dvp{};
-    d3dvp.TopLeftX = static_cast<float>(eyeTarget.viewport.Pos.x);
-    d3dvp.TopLeftY = static_cast<float>(eyeTarget.viewport.Pos.y);
-    d3dvp.Width = static_cast<float>(eyeTarget.viewport.Size.w);
-    d3dvp.Height = static_cast<float>(eyeTarget.viewport.Size.h);
+    d3dvp.TopLeftX = static_cast<float>(viewTarget.viewport.Pos.x);
+    d3dvp.TopLeftY = static_cast<float>(viewTarget.viewport.Pos.y);
+    d3dvp.Width = static_cast<float>(viewTarget.viewport.Size.w);
+    d3dvp.Height = static_cast<float>(viewTarget.viewport.Size.h);
     d3dvp.MinDepth = 0.f;
     d3dvp.MaxDepth = 1.f;
-    context->RSSetViewports(1, &d3dvp);
+    deferredContext->RSSetViewports(1, &d3dvp);
+    boundTexture = nullptr;
+}
+
+ID3D11CommandListPtr DirectX11::FinishRecording() {
+    ID3D11CommandListPtr commandList;
+    ThrowOnFailure(deferredContext->FinishCommandList(FALSE, &commandList));
+    return commandList;
 }
 
 void DirectX11::Render(ID3D11ShaderResourceView* texSrv, ID3D11Buffer* vertices,
                        ID3D11Buffer* indices, UINT stride, int count) {
-    context->IASetInputLayout(inputLayout);
-    context->IASetIndexBuffer(indices, DXGI_FORMAT_R16_UINT, 0);
+    deferredContext->IASetInputLayout(inputLayout);
+    deferredContext->IASetIndexBuffer(indices, DXGI_FORMAT_R16_UINT, 0);
 
     UINT offset = 0;
     ID3D11Buffer* vertexBuffers[] = {vertices};
-    context->IASetVertexBuffers(0, 1, vertexBuffers, &stride, &offset);
+    deferredContext->IASetVertexBuffers(0, 1, vertexBuffers, &stride, &offset);
 
     D3D11_MAPPED_SUBRESOURCE map;
-    context->Map(uniformBufferGen, 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
-    memcpy(map.pData, uniformData.data(), uniformData.size());
-    context->Unmap(uniformBufferGen, 0);
+    deferredContext->Map(uniformBufferGen, 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+    memcpy(map.pData, uniforms.data.data(), uniforms.data.size());
+    deferredContext->Unmap(uniformBufferGen, 0);
 
     ID3D11Buffer* vsConstantBuffers[] = {uniformBufferGen};
-    context->VSSetConstantBuffers(0, 1, vsConstantBuffers);
+    deferredContext->VSSetConstantBuffers(0, 1, vsConstantBuffers);
 
-    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    context->VSSetShader(vShader, nullptr, 0);
-    context->PSSetShader(pShader, nullptr, 0);
+    deferredContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    deferredContext->VSSetShader(vShader, nullptr, 0);
+    deferredContext->PSSetShader(pShader, nullptr, 0);
     ID3D11SamplerState* samplerStates[] = {samplerState};
-    context->PSSetSamplers(0, 1, samplerStates);
-    if (texSrv) {
+    deferredContext->PSSetSamplers(0, 1, samplerStates);
+    if (texSrv && texSrv != boundTexture) {  // Draws are sorted by texture, see DrawList
         ID3D11ShaderResourceView* srvs[] = {texSrv};
-        context->PSSetShaderResources(0, 1, srvs);
+        deferredContext->PSSetShaderResources(0, 1, srvs);
+        boundTexture = texSrv;
     }
-    context->DrawIndexed(count, 0, 0);
+    deferredContext->DrawIndexed(count, 0, 0);
 }
 
 bool DirectX11::IsAnyKeyPressed() const {
     return any_of(begin(keys), end(keys), [](bool b) { return b; });
 }
 
-void DirectX11::SetUniform(const char* name, int n, const float* v) {
-    memcpy(uniformData.data() + uniformOffsets[name], v, n * sizeof(float));
+void DirectX11::Draw(const Model& model) {
+    Render(model.textureSrv, model.vertexBuffer, model.indexBuffer, sizeof(Model::Vertex),
+           model.indices.size());
 }
 
-void Model::AllocateBuffers(ID3D11Device* device) {
+void DirectX11::SetUniform(const char* name, int n, const float* v) { uniforms.Set(name, n, v); }
+
+void Model::AllocateBuffers(ID3D11Device* device, ResourceRegistry& resources) {
     D3D11_SUBRESOURCE_DATA sr{};
 
     const CD3D11_BUFFER_DESC vbdesc(vertices.size() * sizeof(vertices[0]), D3D11_BIND_VERTEX_BUFFER,
                                     D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
     sr.pSysMem = vertices.data();
-    ThrowOnFailure(device->CreateBuffer(&vbdesc, &sr, &vertexBuffer));
+    vertexBuffer = resources.CreateBuffer(device, vbdesc, &sr, ResourceRegistry::VertexBuffer,
+                                          "Model vertices");
 
     const CD3D11_BUFFER_DESC ibdesc(indices.size() * sizeof(indices[0]), D3D11_BIND_INDEX_BUFFER,
                                     D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
     sr.pSysMem = indices.data();
-    ThrowOnFailure(device->CreateBuffer(&ibdesc, &sr, &indexBuffer));
+    indexBuffer = resources.CreateBuffer(device, ibdesc, &sr, ResourceRegistry::IndexBuffer,
+                                         "Model indices");
 }
 
-void Model::AddSolidColorBox(float x1, float y1, float z1, float x2, float y2, float z2, Color c) {
-    const uint16_t CubeIndices[] = {0,  1,  3,  3,  1,  2,  5,  4,  6,  6,  4,  7,
-                                    8,  9,  11, 11, 9,  10, 13, 12, 14, 14, 12, 15,
-                                    16, 17, 19, 19, 17, 18, 21, 20, 22, 22, 20, 23};
-
-    const uint16_t offset = static_cast<uint16_t>(vertices.size());
-    for (const auto& index : CubeIndices) indices.push_back(index + offset);
-
-    const Vector3f Vert[][2] = {
-        Vector3f(x1, y2, z1), Vector3f(z1, x1), Vector3f(x2, y2, z1), Vector3f(z1, x2),
-        Vector3f(x2, y2, z2), Vector3f(z2, x2), Vector3f(x1, y2, z2), Vector3f(z2, x1),
-        Vector3f(x1, y1, z1), Vector3f(z1, x1), Vector3f(x2, y1, z1), Vector3f(z1, x2),
-        Vector3f(x2, y1, z2), Vector3f(z2, x2), Vector3f(x1, y1, z2), Vector3f(z2, x1),
-        Vector3f(x1, y1, z2), Vector3f(z2, y1), Vector3f(x1, y1, z1), Vector3f(z1, y1),
-        Vector3f(x1, y2, z1), Vector3f(z1, y2), Vector3f(x1, y2, z2), Vector3f(z2, y2),
-        Vector3f(x2, y1, z2), Vector3f(z2, y1), Vector3f(x2, y1, z1), Vector3f(z1, y1),
-        Vector3f(x2, y2, z1), Vector3f(z1, y2), Vector3f(x2, y2, z2), Vector3f(z2, y2),
-        Vector3f(x1, y1, z1), Vector3f(x1, y1), Vector3f(x2, y1, z1), Vector3f(x2, y1),
-        Vector3f(x2, y2, z1), Vector3f(x2, y2), Vector3f(x1, y2, z1), Vector3f(x1, y2),
-        Vector3f(x1, y1, z2), Vector3f(x1, y1), Vector3f(x2, y1, z2), Vector3f(x2, y1),
-        Vector3f(x2, y2, z2), Vector3f(x2, y2), Vector3f(x1, y2, z2), Vector3f(x1, y2),
-    };
-
-    for (int v = 0; v < 24; ++v) {
-        Vertex vvv;
-        vvv.pos = Vert[v][0];
-        vvv.u = Vert[v][1].x;
-        vvv.v = Vert[v][1].y;
-        vvv.c = c;
-        vertices.push_back(vvv);
+ID3D11ShaderResourceViewPtr CreateTexture(ID3D11Device* device, ResourceRegistry& resources,
+                                          const TextureData& data, const char* name) {
+    const auto mipLevels = static_cast<UINT>(data.mips.size());
+    CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, data.width, data.height, 1, mipLevels);
+    vector<D3D11_SUBRESOURCE_DATA> initData(mipLevels);
+    for (auto level = 0u; level < mipLevels; ++level) {
+        initData[level].pSysMem = data.mips[level].data();
+        initData[level].SysMemPitch =
+            static_cast<UINT>(max(data.width >> level, 1) * sizeof(Model::Color));
     }
+    const auto tex =
+        resources.CreateTexture2D(device, desc, initData.data(), ResourceRegistry::Texture, name);
+    ID3D11ShaderResourceViewPtr texSrv;
+    ThrowOnFailure(device->CreateShaderResourceView(tex, nullptr, &texSrv));
+    return texSrv;
 }
 
-Scene::Scene(ID3D11Device* device, ID3D11DeviceContext* deviceContext) {
-    // Construct textures
-    const auto texWidthHeight = 256;
+Scene::Scene(DirectX11& dx11, AssetLoader<DirectX11>& loader)
+    : resources(dx11.resources), evictionCallback{dx11.resources.evictionCallbacks.size()} {
+    using Payload = AssetLoader<DirectX11>::Payload;
+
+    // Uploads that still don't fit after eviction fail their load, leaving models on the
+    // placeholder texture or undrawn
+    resources.evictionCallbacks.push_back([this](size_t bytes) { EvictTextures(bytes); });
+
+    // Models are drawn with a flat grey placeholder until their texture has been uploaded
+    TextureData placeholder{1, 1};
+    placeholder.mips[0][0] = Model::Color(128, 128, 128, 255);
+    placeholderTexture =
+        CreateTexture(dx11.device, dx11.resources, placeholder, "Placeholder texture");
+
+    // Construct geometry. Boxes are added to a scratch mesh on a worker thread, the finished
+    // vertices and indices are moved into the scene model when its buffers are created.
     const auto texCount = 5;
-    ID3D11ShaderResourceViewPtr generated_texture[texCount];
+    array<vector<Model*>, texCount> textureUsers;
+    auto addModel = [this, &loader, &textureUsers](int texture, function<void(Mesh&)> addBoxes) {
+        models.emplace_back(make_unique<Model>(Vector3f(0, 0, 0), placeholderTexture));
+        Model* model = models.back().get();
+        textureUsers[texture].push_back(model);
+        loads.push_back(loader.Load([model, addBoxes]() -> Payload {
+            auto geometry = make_shared<Mesh>();
+            addBoxes(*geometry);
+            const auto bounds = ComputeBounds(*geometry);
+            const auto bytes = geometry->vertices.size() * sizeof(Mesh::Vertex) +
+                               geometry->indices.size() * sizeof(uint16_t);
+            return Payload{bytes, [model, geometry, bounds](DirectX11& dx) {
+                               model->bounds = bounds;
+                               model->vertices = move(geometry->vertices);
+                               model->indices = move(geometry->indices);
+                               model->AllocateBuffers(dx.device, dx.resources);
+                           }};
+        }));
+    };
 
-    for (int k = 0; k < texCount; ++k) {
-        vector<Model::Color> tex_pixels(texWidthHeight * texWidthHeight);
-        for (int j = 0; j < texWidthHeight; ++j)
-            for (int i = 0; i < texWidthHeight; ++i) {
-                if (k == 0)
-                    tex_pixels[j * texWidthHeight + i] =
-                        (((i >> 7) ^ (j >> 7)) & 1) ? Model::Color(180, 180, 180, 255)
-                                                    : Model::Color(80, 80, 80, 255);  // floor
-                if (k == 1)
-                    tex_pixels[j * texWidthHeight + i] =
-                        (((j / 4 & 15) == 0) ||
-                         (((i / 4 & 15) == 0) && ((((i / 4 & 31) == 0) ^ ((j / 4 >> 4) & 1)) == 0)))
-                            ? Model::Color(60, 60, 60, 255)
-                            : Model::Color(180, 180, 180, 255);  // wall
-                if (k == 2 || k == 4)
-                    tex_pixels[j * texWidthHeight + i] =
-                        (i / 4 == 0 || j / 4 == 0) ? Model::Color(80, 80, 80, 255)
-                                                   : Model::Color(180, 180, 180, 255);  // ceiling
-                if (k == 3)
-                    tex_pixels[j * texWidthHeight + i] = Model::Color(128, 128, 128, 255);  // blank
-            }
+    addModel(2, [](Mesh& m) {  // Moving box
+        m.AddSolidColorBox(0, 0, 0, +1.0f, +1.0f, 1.0f, Mesh::Color(64, 64, 64));
+    });
+
+    addModel(1, [](Mesh& m) {  // Walls
+        m.AddSolidColorBox(-10.1f, 0.0f, -20.0f, -10.0f, 4.0f, 20.0f,
+                           Mesh::Color(128, 128, 128));  // Left Wall
+        m.AddSolidColorBox(-10.0f, -0.1f, -20.1f, 10.0f, 4.0f, -20.0f,
+                           Mesh::Color(128, 128, 128));  // Back Wall
+        m.AddSolidColorBox(10.0f, -0.1f, -20.0f, 10.1f, 4.0f, 20.0f,
+                           Mesh::Color(128, 128, 128));  // Right Wall
+    });
+
+    addModel(0, [](Mesh& m) {  // Floors
+        m.AddSolidColorBox(-10.0f, -0.1f, -20.0f, 10.0f, 0.0f, 20.1f,
+                           Mesh::Color(128, 128, 128));  // Main floor
+        m.AddSolidColorBox(-15.0f, -6.1f, 18.0f, 15.0f, -6.0f, 30.0f,
+                           Mesh::Color(128, 128, 128));  // Bottom floor
+    });
+
+    addModel(4, [](Mesh& m) {  // Ceiling
+        m.AddSolidColorBox(-10.0f, 4.0f, -20.0f, 10.0f, 4.1f, 20.1f, Mesh::Color(128, 128, 128));
+    });
+
+    addModel(3, [](Mesh& m) {  // Fixtures & furniture
+        const Mesh::Color shelf(96, 96, 96), bar(128, 128, 128), table(128, 128, 0),
+            chair(44, 44, 128), post(64, 64, 64);
+        vector<BoxDesc> boxes = {
+            {9.5f, 0.75f, 3.0f, 10.1f, 2.5f, 3.1f, shelf},        // Right side shelf// Verticals
+            {9.5f, 0.95f, 3.7f, 10.1f, 2.75f, 3.8f, shelf},       // Right side shelf
+            {9.55f, 1.20f, 2.5f, 10.1f, 1.30f, 3.75f, shelf},     // Right side shelf// Horizontals
+            {9.55f, 2.00f, 3.05f, 10.1f, 2.10f, 4.2f, shelf},     // Right side shelf
+            {5.0f, 1.1f, 20.0f, 10.0f, 1.2f, 20.1f, shelf},       // Right railing
+            {-10.0f, 1.1f, 20.0f, -5.0f, 1.2f, 20.1f, shelf},     // Left railing
+        };
+        for (float f = 5.0f; f <= 9.0f; f += 1.0f) {
+            boxes.push_back({f, 0.0f, 20.0f, f + 0.1f, 1.1f, 20.1f, bar});    // Left Bars
+            boxes.push_back({-f, 1.1f, 20.0f, -f - 0.1f, 0.0f, 20.1f, bar});  // Right Bars
+        }
+        const BoxDesc furniture[] = {
+            {-1.8f, 0.8f, 1.0f, 0.0f, 0.7f, 0.0f, table},         // Table
+            {-1.8f, 0.0f, 0.0f, -1.7f, 0.7f, 0.1f, table},        // Table Leg
+            {-1.8f, 0.7f, 1.0f, -1.7f, 0.0f, 0.9f, table},        // Table Leg
+            {0.0f, 0.0f, 1.0f, -0.1f, 0.7f, 0.9f, table},         // Table Leg
+            {0.0f, 0.7f, 0.0f, -0.1f, 0.0f, 0.1f, table},         // Table Leg
+            {-1.4f, 0.5f, -1.1f, -0.8f, 0.55f, -0.5f, chair},     // Chair Set
+            {-1.4f, 0.0f, -1.1f, -1.34f, 1.0f, -1.04f, chair},    // Chair Leg 1
+            {-1.4f, 0.5f, -0.5f, -1.34f, 0.0f, -0.56f, chair},    // Chair Leg 2
+            {-0.8f, 0.0f, -0.5f, -0.86f, 0.5f, -0.56f, chair},    // Chair Leg 2
+            {-0.8f, 1.0f, -1.1f, -0.86f, 0.0f, -1.04f, chair},    // Chair Leg 2
+            {-1.4f, 0.97f, -1.05f, -0.8f, 0.92f, -1.10f, chair},  // Chair Back high bar
+        };
+        boxes.insert(boxes.end(), begin(furniture), end(furniture));
 
-        generated_texture[k] = [device, deviceContext, texWidthHeight](unsigned char* data) {
-            CD3D11_TEXTURE2D_DESC dsDesc(DXGI_FORMAT_R8G8B8A8_UNORM, texWidthHeight,
-                                         texWidthHeight);
-            ID3D11Texture2DPtr tex;
-            device->CreateTexture2D(&dsDesc, nullptr, &tex);
-            ID3D11ShaderResourceViewPtr texSrv;
-            device->CreateShaderResourceView(tex, nullptr, &texSrv);
-
-            // Note data is trashed
-            auto wh = texWidthHeight;
-            tex->GetDesc(&dsDesc);
-            for (auto level = 0u; level < dsDesc.MipLevels; ++level) {
-                deviceContext->UpdateSubresource(tex, level, nullptr, data, wh * 4, wh * 4);
-                for (int j = 0; j < (wh & ~1); j += 2) {
-                    const uint8_t* psrc = data + (wh * j * 4);
-                    uint8_t* pdest = data + ((wh >> 1) * (j >> 1) * 4);
-                    for (int i = 0; i < (wh >> 1); ++i, psrc += 8, pdest += 4) {
-                        pdest[0] =
-                            (((int)psrc[0]) + psrc[4] + psrc[wh * 4 + 0] + psrc[wh * 4 + 4]) >> 2;
-                        pdest[1] =
-                            (((int)psrc[1]) + psrc[5] + psrc[wh * 4 + 1] + psrc[wh * 4 + 5]) >> 2;
-                        pdest[2] =
-                            (((int)psrc[2]) + psrc[6] + psrc[wh * 4 + 2] + psrc[wh * 4 + 6]) >> 2;
-                        pdest[3] =
-                            (((int)psrc[3]) + psrc[7] + psrc[wh * 4 + 3] + psrc[wh * 4 + 7]) >> 2;
-                    }
-                }
-                wh >>= 1;
-            }
-            return texSrv;
-        }(&tex_pixels[0].r);
-    }
+        for (float f = 3.0f; f <= 6.6f; f += 0.4f)
+            boxes.push_back({-3, 0.0f, f, -2.9f, 1.3f, f + 0.1f, post});  // Posts
+        m.AddSolidColorBoxes(boxes.data(), boxes.size());
+    });
 
-    // Construct geometry
-    unique_ptr<Model> m =
-        make_unique<Model>(Vector3f(0, 0, 0), generated_texture[2]);  // Moving box
-    m->AddSolidColorBox(0, 0, 0, +1.0f, +1.0f, 1.0f, Model::Color(64, 64, 64));
-    m->AllocateBuffers(device);
-    models.emplace_back(move(m));
-
-    m = make_unique<Model>(Vector3f(0, 0, 0), generated_texture[1]);  // Walls
-    m->AddSolidColorBox(-10.1f, 0.0f, -20.0f, -10.0f, 4.0f, 20.0f,
-                        Model::Color(128, 128, 128));  // Left Wall
-    m->AddSolidColorBox(-10.0f, -0.1f, -20.1f, 10.0f, 4.0f, -20.0f,
-                        Model::Color(128, 128, 128));  // Back Wall
-    m->AddSolidColorBox(10.0f, -0.1f, -20.0f, 10.1f, 4.0f, 20.0f,
-                        Model::Color(128, 128, 128));  // Right Wall
-    m->AllocateBuffers(device);
-    models.emplace_back(move(m));
-
-    m = make_unique<Model>(Vector3f(0, 0, 0), generated_texture[0]);  // Floors
-    m->AddSolidColorBox(-10.0f, -0.1f, -20.0f, 10.0f, 0.0f, 20.1f,
-                        Model::Color(128, 128, 128));  // Main floor
-    m->AddSolidColorBox(-15.0f, -6.1f, 18.0f, 15.0f, -6.0f, 30.0f,
-                        Model::Color(128, 128, 128));  // Bottom floor
-    m->AllocateBuffers(device);
-    models.emplace_back(move(m));
-
-    m = make_unique<Model>(Vector3f(0, 0, 0), generated_texture[4]);  // Ceiling
-    m->AddSolidColorBox(-10.0f, 4.0f, -20.0f, 10.0f, 4.1f, 20.1f, Model::Color(128, 128, 128));
-    m->AllocateBuffers(device);
-    models.emplace_back(move(m));
-
-    m = make_unique<Model>(Vector3f(0, 0, 0), generated_texture[3]);  // Fixtures & furniture
-    m->AddSolidColorBox(9.5f, 0.75f, 3.0f, 10.1f, 2.5f, 3.1f,
-                        Model::Color(96, 96, 96));  // Right side shelf// Verticals
-    m->AddSolidColorBox(9.5f, 0.95f, 3.7f, 10.1f, 2.75f, 3.8f,
-                        Model::Color(96, 96, 96));  // Right side shelf
-    m->AddSolidColorBox(9.55f, 1.20f, 2.5f, 10.1f, 1.30f, 3.75f,
-                        Model::Color(96, 96, 96));  // Right side shelf// Horizontals
-    m->AddSolidColorBox(9.55f, 2.00f, 3.05f, 10.1f, 2.10f, 4.2f,
-                        Model::Color(96, 96, 96));  // Right side shelf
-    m->AddSolidColorBox(5.0f, 1.1f, 20.0f, 10.0f, 1.2f, 20.1f,
-                        Model::Color(96, 96, 96));  // Right railing
-    m->AddSolidColorBox(-10.0f, 1.1f, 20.0f, -5.0f, 1.2f, 20.1f,
-                        Model::Color(96, 96, 96));  // Left railing
-    for (float f = 5.0f; f <= 9.0f; f += 1.0f) {
-        m->AddSolidColorBox(f, 0.0f, 20.0f, f + 0.1f, 1.1f, 20.1f,
-                            Model::Color(128, 128, 128));  // Left Bars
-        m->AddSolidColorBox(-f, 1.1f, 20.0f, -f - 0.1f, 0.0f, 20.1f,
-                            Model::Color(128, 128, 128));  // Right Bars
+    // Construct textures
+    const auto texWidthHeight = 256;
+    for (int k = 0; k < texCount; ++k) {
+        const auto users = textureUsers[k];
+        loads.push_back(loader.Load([this, k, texWidthHeight, users]() -> Payload {
+            auto tex = make_shared<TextureData>(texWidthHeight, texWidthHeight);
+            FillRoomTexture(*tex, k);
+            tex->BuildMips();
+
+            return Payload{tex->SizeInBytes(), [this, tex, users](DirectX11& dx) {
+                               const auto texSrv =
+                                   CreateTexture(dx.device, dx.resources, *tex, "Room texture");
+                               for (auto model : users) model->textureSrv = texSrv;
+                               textures.push_back(LoadedTexture{tex, users, texSrv});
+                           }};
+        }));
     }
-    m->AddSolidColorBox(-1.8f, 0.8f, 1.0f, 0.0f, 0.7f, 0.0f, Model::Color(128, 128, 0));  // Table
-    m->AddSolidColorBox(-1.8f, 0.0f, 0.0f, -1.7f, 0.7f, 0.1f,
-                        Model::Color(128, 128, 0));  // Table Leg
-    m->AddSolidColorBox(-1.8f, 0.7f, 1.0f, -1.7f, 0.0f, 0.9f,
-                        Model::Color(128, 128, 0));  // Table Leg
-    m->AddSolidColorBox(0.0f, 0.0f, 1.0f, -0.1f, 0.7f, 0.9f,
-                        Model::Color(128, 128, 0));  // Table Leg
-    m->AddSolidColorBox(0.0f, 0.7f, 0.0f, -0.1f, 0.0f, 0.1f,
-                        Model::Color(128, 128, 0));  // Table Leg
-    m->AddSolidColorBox(-1.4f, 0.5f, -1.1f, -0.8f, 0.55f, -0.5f,
-                        Model::Color(44, 44, 128));  // Chair Set
-    m->AddSolidColorBox(-1.4f, 0.0f, -1.1f, -1.34f, 1.0f, -1.04f,
-                        Model::Color(44, 44, 128));  // Chair Leg 1
-    m->AddSolidColorBox(-1.4f, 0.5f, -0.5f, -1.34f, 0.0f, -0.56f,
-                        Model::Color(44, 44, 128));  // Chair Leg 2
-    m->AddSolidColorBox(-0.8f, 0.0f, -0.5f, -0.86f, 0.5f, -0.56f,
-                        Model::Color(44, 44, 128));  // Chair Leg 2
-    m->AddSolidColorBox(-0.8f, 1.0f, -1.1f, -0.86f, 0.0f, -1.04f,
-                        Model::Color(44, 44, 128));  // Chair Leg 2
-    m->AddSolidColorBox(-1.4f, 0.97f, -1.05f, -0.8f, 0.92f, -1.10f,
-                        Model::Color(44, 44, 128));  // Chair Back high bar
-
-    for (float f = 3.0f; f <= 6.6f; f += 0.4f)
-        m->AddSolidColorBox(-3, 0.0f, f, -2.9f, 1.3f, f + 0.1f, Model::Color(64, 64, 64));  // Posts
-
-    m->AllocateBuffers(device);
-    models.emplace_back(move(m));
 }
 
-void Scene::Render(DirectX11& dx11, const Matrix4f& view, const Matrix4f& proj) {
-    dx11.SetUniform("Proj", 16, &proj.Transposed().M[0][0]);
-    dx11.SetUniform("View", 16, &view.Transposed().M[0][0]);
-    for (auto& model : models) {
-        dx11.SetUniform("World", 16, &model->GetMatrix().Transposed().M[0][0]);
-        dx11.Render(model->textureSrv, model->vertexBuffer, model->indexBuffer,
-                    sizeof(Model::Vertex), model->indices.size());
+Scene::~Scene() { resources.evictionCallbacks[evictionCallback] = nullptr; }
+
+void Scene::EvictTextures(size_t bytes) {
+    const auto liveBytes = resources.LiveBytes();
+    const auto target = liveBytes > bytes ? liveBytes - bytes : 0;
+    for (auto& texture : textures) {
+        if (resources.LiveBytes() <= target) break;
+        if (!texture.srv) continue;
+        // The texture is destroyed, and its bytes released, with the last reference to it
+        for (auto model : texture.users) model->textureSrv = placeholderTexture;
+        texture.srv = nullptr;
     }
 }
+
+void Scene::RestoreTextures(DirectX11& dx11) {
+    const auto evicted = find_if(begin(textures), end(textures),
+                                 [](const LoadedTexture& texture) { return !texture.srv; });
+    if (evicted == end(textures)) return;
+    // Only when it fits without evicting another texture in turn
+    if (resources.LiveBytes() + evicted->data->SizeInBytes() > resources.budget) return;
+    evicted->srv = CreateTexture(dx11.device, resources, *evicted->data, "Room texture");
+    for (auto model : evicted->users) model->textureSrv = evicted->srv;
+}
+
+void Scene::Cull(const Frustum* frustums, size_t viewCount) {
+    drawList.Build(models, frustums, viewCount);
+}
+
+void Scene::Render(DirectX11& dx11, size_t view) const { drawList.Render(dx11, view); }
@@ -0,0 +1,169 @@
+#include "pose_predictor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace OVR;
+using namespace std;
+
+Vector3f RotationVector(Quatf q) {
+    if (q.w < 0) q = Quatf(-q.x, -q.y, -q.z, -q.w);
+    const Vector3f axis{q.x, q.y, q.z};
+    const float sinHalfAngle = axis.Length();
+    if (sinHalfAngle < 1e-6f) return axis * 2.0f;
+    return axis * (2.0f * atan2(sinHalfAngle, q.w) / sinHalfAngle);
+}
+
+Quatf RotationFromVector(const Vector3f& v) {
+    const float angle = v.Length();
+    if (angle < 1e-6f) return Quatf(v.x * 0.5f, v.y * 0.5f, v.z * 0.5f, 1.0f).Normalized();
+    const float s = sin(angle * 0.5f) / angle;
+    return Quatf(v.x * s, v.y * s, v.z * s, cos(angle * 0.5f));
+}
+
+ostream& operator<<(ostream& os, const PoseSample& sample) {
+    const auto& q = sample.orientation;
+    const auto& p = sample.position;
+    os.precision(17);
+    return os << sample.time << ' ' << q.x << ' ' << q.y << ' ' << q.z << ' ' << q.w << ' '
+              << p.x << ' ' << p.y << ' ' << p.z;
+}
+
+istream& operator>>(istream& is, PoseSample& sample) {
+    auto& q = sample.orientation;
+    auto& p = sample.position;
+    return is >> sample.time >> q.x >> q.y >> q.z >> q.w >> p.x >> p.y >> p.z;
+}
+
+void PosePredictor::AddSample(const PoseSample& sample) {
+    if (!history.empty()) {
+        const auto& last = history.back();
+        const auto dt = static_cast<float>(sample.time - last.time);
+        if (dt <= 0) return;  // Repeated or out of order sample
+
+        const auto angVel = RotationVector(sample.orientation * last.orientation.Inverted()) / dt;
+        const auto linVel = (sample.position - last.position) / dt;
+        if (angVel.Length() > maxAngularSpeed || linVel.Length() > maxLinearSpeed) {
+            Reset();
+        } else if (history.size() == 1) {
+            angularVelocity = angVel;
+            linearVelocity = linVel;
+        } else {
+            const auto angAcc = (angVel - angularVelocity) / dt;
+            const auto linAcc = (linVel - linearVelocity) / dt;
+            angularVelocity += (angVel - angularVelocity) * smoothing;
+            linearVelocity += (linVel - linearVelocity) * smoothing;
+            angularAcceleration += (angAcc - angularAcceleration) * smoothing;
+            linearAcceleration += (linAcc - linearAcceleration) * smoothing;
+        }
+    }
+    history.push_back(sample);
+    while (history.size() > historySize) history.pop_front();
+}
+
+void PosePredictor::Reset() {
+    history.clear();
+    angularVelocity = angularAcceleration = Vector3f();
+    linearVelocity = linearAcceleration = Vector3f();
+}
+
+PoseSample PosePredictor::Predict(double targetTime) const {
+    if (history.empty()) return PoseSample{targetTime, Quatf(), Vector3f()};
+
+    const auto& last = history.back();
+    const auto dt = static_cast<float>(min(max(targetTime - last.time, 0.0), maxHorizon));
+    auto rotation = angularVelocity * dt;
+    auto translation = linearVelocity * dt;
+    if (mode == Mode::ConstantAcceleration) {
+        rotation += angularAcceleration * (0.5f * dt * dt);
+        translation += linearAcceleration * (0.5f * dt * dt);
+    }
+    return PoseSample{targetTime, (RotationFromVector(rotation) * last.orientation).Normalized(),
+                      last.position + translation};
+}
+
+int RunPoseHarness(const string& tracePath) {
+    vector<PoseSample> trace;
+    ifstream in{tracePath};
+    for (PoseSample sample; in >> sample;) trace.push_back(sample);
+    if (trace.size() < 2) {
+        cerr << "Pose trace " << tracePath << " needs at least two samples" << endl;
+        return 1;
+    }
+
+    // Ground truth between recorded samples
+    auto actualPose = [&trace](double time) -> PoseSample {
+        auto next = upper_bound(begin(trace), end(trace), time,
+                                [](double t, const PoseSample& s) { return t < s.time; });
+        if (next == begin(trace)) return trace.front();
+        if (next == end(trace)) return trace.back();
+        const auto& prev = *(next - 1);
+        const auto a = static_cast<float>((time - prev.time) / (next->time - prev.time));
+        const auto delta = RotationVector(next->orientation * prev.orientation.Inverted());
+        return PoseSample{time, RotationFromVector(delta * a) * prev.orientation,
+                          prev.position + (next->position - prev.position) * a};
+    };
+
+    ofstream report{tracePath + ".report.csv"};
+    report << "mode,smoothing,horizon_ms,predictions,mean_error_deg,max_error_deg,"
+              "mean_error_mm,max_error_mm,ns_per_sample\n";
+
+    const PosePredictor::Mode modes[] = {PosePredictor::Mode::ConstantVelocity,
+                                         PosePredictor::Mode::ConstantAcceleration};
+    const float smoothings[] = {1.0f, 0.5f, 0.25f};
+    const double horizons[] = {0.011, 0.022, 0.044};
+    for (auto mode : modes)
+        for (auto smoothing : smoothings)
+            for (auto horizon : horizons) {
+                PosePredictor predictor;
+                predictor.mode = mode;
+                predictor.smoothing = smoothing;
+
+                // Accuracy against the trace itself
+                int predictions = 0;
+                double sumDeg = 0, maxDeg = 0, sumMm = 0, maxMm = 0;
+                for (const auto& sample : trace) {
+                    predictor.AddSample(sample);
+                    const auto target = sample.time + horizon;
+                    if (target > trace.back().time) break;
+                    const auto predicted = predictor.Predict(target);
+                    const auto actual = actualPose(target);
+                    const double errorDeg =
+                        RadToDegree(RotationVector(predicted.orientation *
+                                                   actual.orientation.Inverted()).Length());
+                    const double errorMm = (predicted.position - actual.position).Length() * 1000;
+                    ++predictions;
+                    sumDeg += errorDeg;
+                    sumMm += errorMm;
+                    maxDeg = max(maxDeg, errorDeg);
+                    maxMm = max(maxMm, errorMm);
+                }
+
+                // Cost of one update and prediction, without the ground truth lookups
+                PosePredictor timed;
+                timed.mode = mode;
+                timed.smoothing = smoothing;
+                volatile float sink = 0;
+                const auto start = chrono::high_resolution_clock::now();
+                for (const auto& sample : trace) {
+                    timed.AddSample(sample);
+                    sink = timed.Predict(sample.time + horizon).orientation.w;
+                }
+                const auto elapsed = chrono::high_resolution_clock::now() - start;
+                (void)sink;  // Only written so the predictions aren't optimized away
+                const auto nsPerSample =
+                    chrono::duration<double, nano>(elapsed).count() / trace.size();
+
+                report << (mode == PosePredictor::Mode::ConstantVelocity ? "velocity"
+                                                                          : "acceleration")
+                       << ',' << smoothing << ',' << horizon * 1000 << ',' << predictions << ','
+                       << sumDeg / max(predictions, 1) << ',' << maxDeg << ','
+                       << sumMm / max(predictions, 1) << ',' << maxMm << ',' << nsPerSample
+                       << '\n';
+            }
+    return 0;
+}
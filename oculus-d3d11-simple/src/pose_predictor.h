@@ -0,0 +1,54 @@
+// Head pose prediction to display time, and an offline harness to evaluate it against recorded
+// tracking data. Only depends on OVR_Math so traces can be evaluated on any platform.
+
+#pragma once
+
+#include <Kernel/OVR_Math.h>
+
+#include <deque>
+#include <iosfwd>
+#include <string>
+
+// Head pose reported by the tracker for a point in time.
+struct PoseSample {
+    double time;
+    OVR::Quatf orientation;
+    OVR::Vector3f position;
+};
+
+std::ostream& operator<<(std::ostream& os, const PoseSample& sample);
+std::istream& operator>>(std::istream& is, PoseSample& sample);
+
+// Rotation vector (axis scaled by angle) of the shortest rotation represented by q, and back.
+OVR::Vector3f RotationVector(OVR::Quatf q);
+OVR::Quatf RotationFromVector(const OVR::Vector3f& v);
+
+// Keeps a short history of tracked head poses and extrapolates it to a target display time.
+// Velocities are estimated from consecutive samples and exponentially smoothed.
+struct PosePredictor {
+    enum class Mode { ConstantVelocity, ConstantAcceleration };
+
+    Mode mode = Mode::ConstantVelocity;
+    float smoothing = 0.5f;    // Weight of the newest velocity estimate, 1 disables filtering
+    double maxHorizon = 0.1;   // Never extrapolate further ahead than this, in seconds
+    size_t historySize = 32;
+    // Samples implying faster motion than this are tracking discontinuities, such as a recenter,
+    // and restart the history instead of being read as velocity
+    float maxAngularSpeed = 35.0f;   // Radians per second
+    float maxLinearSpeed = 10.0f;    // Meters per second
+    std::deque<PoseSample> history;  // Oldest first
+
+    void AddSample(const PoseSample& sample);
+    PoseSample Predict(double targetTime) const;
+    // Forgets the history and motion estimates, call when the tracking origin changes.
+    void Reset();
+
+private:
+    OVR::Vector3f angularVelocity, angularAcceleration;
+    OVR::Vector3f linearVelocity, linearAcceleration;
+};
+
+// Replays a recorded pose trace, as saved by the sample's --record-poses, through predictor
+// variants and writes their accuracy and cost to <trace>.report.csv. Returns non-zero and prints
+// the reason if the trace can't be used.
+int RunPoseHarness(const std::string& tracePath);
@@ -0,0 +1,204 @@
+#include "scene_core.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+using namespace OVR;
+using namespace std;
+
+// Each box vertex picks its position and texture coordinates from the box's x1, y1, z1, x2, y2, z2
+// so that writing a box is a fixed sequence of copies.
+const uint8_t BoxVertexSources[BoxVertexCount][5] = {
+    {0, 4, 2, 2, 0}, {3, 4, 2, 2, 3}, {3, 4, 5, 5, 3}, {0, 4, 5, 5, 0},  // Top
+    {0, 1, 2, 2, 0}, {3, 1, 2, 2, 3}, {3, 1, 5, 5, 3}, {0, 1, 5, 5, 0},  // Bottom
+    {0, 1, 5, 5, 1}, {0, 1, 2, 2, 1}, {0, 4, 2, 2, 4}, {0, 4, 5, 5, 4},  // x1 side
+    {3, 1, 5, 5, 1}, {3, 1, 2, 2, 1}, {3, 4, 2, 2, 4}, {3, 4, 5, 5, 4},  // x2 side
+    {0, 1, 2, 0, 1}, {3, 1, 2, 3, 1}, {3, 4, 2, 3, 4}, {0, 4, 2, 0, 4},  // z1 side
+    {0, 1, 5, 0, 1}, {3, 1, 5, 3, 1}, {3, 4, 5, 3, 4}, {0, 4, 5, 0, 4},  // z2 side
+};
+
+const uint16_t BoxIndices[BoxIndexCount] = {0,  1,  3,  3,  1,  2,  5,  4,  6,  6,  4,  7,
+                                            8,  9,  11, 11, 9,  10, 13, 12, 14, 14, 12, 15,
+                                            16, 17, 19, 19, 17, 18, 21, 20, 22, 22, 20, 23};
+
+void Mesh::AddSolidColorBox(float x1, float y1, float z1, float x2, float y2, float z2, Color c) {
+    const BoxDesc box{x1, y1, z1, x2, y2, z2, c};
+    AddSolidColorBoxes(&box, 1);
+}
+
+void Mesh::AddSolidColorBoxes(const BoxDesc* boxes, size_t count) {
+    const auto firstVertex = vertices.size(), firstIndex = indices.size();
+    if (firstVertex + count * BoxVertexCount > 65536)
+        throw runtime_error{"Too many boxes for 16 bit indices"};
+    vertices.resize(firstVertex + count * BoxVertexCount);
+    indices.resize(firstIndex + count * BoxIndexCount);
+    WriteBoxes(boxes, count, &vertices[firstVertex], &indices[firstIndex],
+               static_cast<uint16_t>(firstVertex));
+}
+
+void WriteBoxes(const BoxDesc* boxes, size_t count, Mesh::Vertex* vertices, uint16_t* indices,
+                uint16_t baseVertex) {
+    for (size_t b = 0; b < count; ++b) {
+        const auto& box = boxes[b];
+        const float coords[] = {box.x1, box.y1, box.z1, box.x2, box.y2, box.z2};
+        for (size_t v = 0; v < BoxVertexCount; ++v, ++vertices) {
+            const auto src = BoxVertexSources[v];
+            vertices->pos = Vector3f{coords[src[0]], coords[src[1]], coords[src[2]]};
+            vertices->c = box.c;
+            vertices->u = coords[src[3]];
+            vertices->v = coords[src[4]];
+        }
+        const auto offset = static_cast<uint16_t>(baseVertex + b * BoxVertexCount);
+        for (size_t i = 0; i < BoxIndexCount; ++i)
+            indices[i] = static_cast<uint16_t>(BoxIndices[i] + offset);
+        indices += BoxIndexCount;
+    }
+}
+
+vector<Mesh> BuildBoxMeshes(const BoxDesc* boxes, size_t count, unsigned threadCount) {
+    vector<Mesh> meshes((count + MaxBoxesPerMesh - 1) / MaxBoxesPerMesh);
+    auto build = [&meshes, boxes, count](size_t first, size_t last) {
+        for (auto m = first; m < last; ++m) {
+            const auto firstBox = m * MaxBoxesPerMesh;
+            meshes[m].AddSolidColorBoxes(boxes + firstBox, min(MaxBoxesPerMesh, count - firstBox));
+        }
+    };
+
+    // Contiguous runs of meshes per thread, the calling thread takes the first
+    if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1u);
+    const auto runs = min<size_t>(threadCount, meshes.size());
+    vector<thread> workers;
+    for (size_t t = 1; t < runs; ++t)
+        workers.emplace_back(build, t * meshes.size() / runs, (t + 1) * meshes.size() / runs);
+    build(0, runs ? meshes.size() / runs : 0);
+    for (auto& worker : workers) worker.join();
+    return meshes;
+}
+
+void TextureData::BuildMips() {
+    auto average = [](int a, int b, int c, int d) {
+        return static_cast<unsigned char>((a + b + c + d) >> 2);
+    };
+
+    mips.resize(1);
+    for (auto w = width, h = height; w > 1 || h > 1;) {
+        const auto dw = max(w >> 1, 1), dh = max(h >> 1, 1);
+        vector<Mesh::Color> dest(dw * dh);
+        const auto& src = mips.back();
+        for (int j = 0; j < dh; ++j) {
+            const auto row0 = min(j * 2, h - 1) * w, row1 = min(j * 2 + 1, h - 1) * w;
+            for (int i = 0; i < dw; ++i) {
+                const auto col0 = min(i * 2, w - 1), col1 = min(i * 2 + 1, w - 1);
+                const auto &p00 = src[row0 + col0], &p01 = src[row0 + col1];
+                const auto &p10 = src[row1 + col0], &p11 = src[row1 + col1];
+                dest[j * dw + i] = Mesh::Color(
+                    average(p00.r, p01.r, p10.r, p11.r), average(p00.g, p01.g, p10.g, p11.g),
+                    average(p00.b, p01.b, p10.b, p11.b), average(p00.a, p01.a, p10.a, p11.a));
+            }
+        }
+        mips.push_back(move(dest));
+        w = dw;
+        h = dh;
+    }
+}
+
+size_t TextureData::SizeInBytes() const {
+    size_t res = 0;
+    for (const auto& mip : mips) res += mip.size() * sizeof(Mesh::Color);
+    return res;
+}
+
+void FillRoomTexture(TextureData& tex, int pattern) {
+    const auto k = pattern;
+    const auto texWidthHeight = tex.width;
+    auto& tex_pixels = tex.mips[0];
+    for (int j = 0; j < tex.height; ++j)
+        for (int i = 0; i < texWidthHeight; ++i) {
+            if (k == 0)
+                tex_pixels[j * texWidthHeight + i] =
+                    (((i >> 7) ^ (j >> 7)) & 1) ? Mesh::Color(180, 180, 180, 255)
+                                                : Mesh::Color(80, 80, 80, 255);  // floor
+            if (k == 1)
+                tex_pixels[j * texWidthHeight + i] =
+                    (((j / 4 & 15) == 0) ||
+                     (((i / 4 & 15) == 0) && ((((i / 4 & 31) == 0) ^ ((j / 4 >> 4) & 1)) == 0)))
+                        ? Mesh::Color(60, 60, 60, 255)
+                        : Mesh::Color(180, 180, 180, 255);  // wall
+            if (k == 2 || k == 4)
+                tex_pixels[j * texWidthHeight + i] =
+                    (i / 4 == 0 || j / 4 == 0) ? Mesh::Color(80, 80, 80, 255)
+                                               : Mesh::Color(180, 180, 180, 255);  // ceiling
+            if (k == 3)
+                tex_pixels[j * texWidthHeight + i] = Mesh::Color(128, 128, 128, 255);  // blank
+        }
+}
+
+void UniformBlock::Set(const char* name, int n, const float* v) {
+    memcpy(data.data() + offsets[name], v, n * sizeof(float));
+}
+
+Matrix4f EyeViewMatrix(float yaw, const Vector3f& pos, const Quatf& eyeOrientation,
+                       const Vector3f& eyePosition) {
+    const Matrix4f rollPitchYaw = Matrix4f::RotationY(yaw);
+    const Matrix4f finalRollPitchYaw = rollPitchYaw * Matrix4f(eyeOrientation);
+    const Vector3f finalUp = finalRollPitchYaw.Transform(Vector3f{0, 1, 0});
+    const Vector3f finalForward = finalRollPitchYaw.Transform(Vector3f{0, 0, -1});
+    const Vector3f shiftedEyePos = pos + rollPitchYaw.Transform(eyePosition);
+    return Matrix4f::LookAtRH(shiftedEyePos, shiftedEyePos + finalForward, finalUp);
+}
+
+BoundingBox ComputeBounds(const Mesh& mesh) {
+    if (mesh.vertices.empty()) return BoundingBox{};
+    BoundingBox res{mesh.vertices[0].pos, mesh.vertices[0].pos};
+    for (const auto& v : mesh.vertices) {
+        res.mins = Vector3f(min(res.mins.x, v.pos.x), min(res.mins.y, v.pos.y),
+                            min(res.mins.z, v.pos.z));
+        res.maxs = Vector3f(max(res.maxs.x, v.pos.x), max(res.maxs.y, v.pos.y),
+                            max(res.maxs.z, v.pos.z));
+    }
+    return res;
+}
+
+BoundingBox TransformBounds(const BoundingBox& box, const Matrix4f& m) {
+    // Each output axis gets the translation plus the smaller and larger products of every input
+    // axis, which bounds all eight transformed corners without transforming them.
+    const float mins[] = {box.mins.x, box.mins.y, box.mins.z};
+    const float maxs[] = {box.maxs.x, box.maxs.y, box.maxs.z};
+    float resMins[3], resMaxs[3];
+    for (int i = 0; i < 3; ++i) {
+        resMins[i] = resMaxs[i] = m.M[i][3];
+        for (int j = 0; j < 3; ++j) {
+            const float a = m.M[i][j] * mins[j], b = m.M[i][j] * maxs[j];
+            resMins[i] += min(a, b);
+            resMaxs[i] += max(a, b);
+        }
+    }
+    return BoundingBox{Vector3f(resMins[0], resMins[1], resMins[2]),
+                       Vector3f(resMaxs[0], resMaxs[1], resMaxs[2])};
+}
+
+Frustum::Frustum(const Matrix4f& viewProj) {
+    // A point is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w in clip space
+    const auto& m = viewProj.M;
+    for (int j = 0; j < 4; ++j) {
+        planes[0][j] = m[3][j] + m[0][j];  // Left
+        planes[1][j] = m[3][j] - m[0][j];  // Right
+        planes[2][j] = m[3][j] + m[1][j];  // Bottom
+        planes[3][j] = m[3][j] - m[1][j];  // Top
+        planes[4][j] = m[2][j];            // Near
+        planes[5][j] = m[3][j] - m[2][j];  // Far
+    }
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const {
+    // Outside if the corner furthest along a plane's normal is behind it
+    for (const auto& p : planes) {
+        const float x = p[0] >= 0 ? box.maxs.x : box.mins.x;
+        const float y = p[1] >= 0 ? box.maxs.y : box.mins.y;
+        const float z = p[2] >= 0 ? box.maxs.z : box.mins.z;
+        if (p[0] * x + p[1] * y + p[2] * z + p[3] < 0) return false;
+    }
+    return true;
+}
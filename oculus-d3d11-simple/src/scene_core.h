@@ -0,0 +1,158 @@
+// Platform independent parts of the room sample: geometry and texture generation, the CPU side
+// uniform block, per view matrices, bounds and frustum culling, and the per frame DrawList shared
+// by all views. Split out of main.cpp so they can be built and benchmarked without D3D11, see
+// main.cpp for the original copyright notice.
+
+#pragma once
+
+#include <Kernel/OVR_Math.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct BoxDesc;
+
+struct Mesh {
+    struct Color {
+        unsigned char r, g, b, a;
+
+        Color(unsigned char r_ = 0, unsigned char g_ = 0, unsigned char b_ = 0,
+              unsigned char a_ = 0xff)
+            : r{r_}, g{g_}, b{b_}, a{a_} {}
+    };
+    struct Vertex {
+        OVR::Vector3f pos;
+        Color c;
+        float u, v;
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<uint16_t> indices;
+
+    void AddSolidColorBox(float x1, float y1, float z1, float x2, float y2, float z2, Color c);
+    // Sizes the mesh once for the whole batch and writes the boxes in place. Throws if the mesh
+    // would need more vertices than 16 bit indices can address.
+    void AddSolidColorBoxes(const BoxDesc* boxes, size_t count);
+};
+
+// A box as passed to AddSolidColorBox, for the batch geometry functions.
+struct BoxDesc {
+    float x1, y1, z1, x2, y2, z2;
+    Mesh::Color c;
+};
+
+const size_t BoxVertexCount = 24;
+const size_t BoxIndexCount = 36;
+const size_t MaxBoxesPerMesh = 65536 / BoxVertexCount;
+
+// Writes count boxes to preallocated storage, such as a mesh or mapped GPU buffers, with room
+// for count * BoxVertexCount vertices and count * BoxIndexCount indices. Indices start at
+// baseVertex. Produces the same geometry as AddSolidColorBox without allocating.
+void WriteBoxes(const BoxDesc* boxes, size_t count, Mesh::Vertex* vertices, uint16_t* indices,
+                uint16_t baseVertex);
+
+// Builds any number of boxes into as few meshes as 16 bit indices allow, spread over threadCount
+// threads, 0 meaning one per hardware thread.
+std::vector<Mesh> BuildBoxMeshes(const BoxDesc* boxes, size_t count, unsigned threadCount = 0);
+
+// CPU side pixels of an RGBA8 texture and its mip chain, ready to be uploaded in one go.
+struct TextureData {
+    int width, height;
+    std::vector<std::vector<Mesh::Color>> mips;  // mips[0] is the full size image
+
+    TextureData(int width_, int height_)
+        : width{width_}, height{height_}, mips(1, std::vector<Mesh::Color>(width_ * height_)) {}
+
+    void BuildMips();
+    size_t SizeInBytes() const;
+};
+
+// Fills the top mip with one of the room's procedural patterns: 0 floor, 1 wall, 2 and 4
+// ceiling, 3 blank.
+void FillRoomTexture(TextureData& tex, int pattern);
+
+// CPU copy of a shader constant buffer, with variable offsets taken from shader reflection.
+struct UniformBlock {
+    std::vector<unsigned char> data;
+    std::unordered_map<std::string, int> offsets;
+
+    void Set(const char* name, int n, const float* v);
+};
+
+// Per view shader constants, only written just before the frame's command list is submitted.
+struct ViewConstants {
+    OVR::Matrix4f proj, view;  // Transposed for HLSL
+};
+
+// View matrix for an eye pose relative to a player standing at pos, turned by yaw.
+OVR::Matrix4f EyeViewMatrix(float yaw, const OVR::Vector3f& pos, const OVR::Quatf& eyeOrientation,
+                            const OVR::Vector3f& eyePosition);
+
+// Axis aligned box around a mesh's vertices.
+struct BoundingBox {
+    OVR::Vector3f mins, maxs;
+};
+
+BoundingBox ComputeBounds(const Mesh& mesh);
+// Smallest axis aligned box containing box after transforming it by m.
+BoundingBox TransformBounds(const BoundingBox& box, const OVR::Matrix4f& m);
+
+// Clip planes of a view projection matrix with D3D depth range, as (a, b, c, d) facing inwards.
+struct Frustum {
+    float planes[6][4];
+
+    explicit Frustum(const OVR::Matrix4f& viewProj);
+
+    // Conservative, may report boxes near the frustum corners as intersecting.
+    bool Intersects(const BoundingBox& box) const;
+};
+
+const size_t MaxViews = 32;
+
+// Models to draw in a frame, shared by all of its views. Transforms, culling and sorting are
+// done once per frame in Build, each view then only issues the draws of the models it can see.
+template <typename Model>
+struct DrawList {
+    struct Item {
+        const Model* model;
+        OVR::Matrix4f world;  // Transposed for HLSL
+        uint32_t viewMask;    // Bit per view the model is visible in
+    };
+    std::vector<Item> items;
+
+    // Culls models against viewCount frustums and sorts the visible ones by SortKey(), so draws
+    // sharing state are adjacent. models are pointers to types with GetMatrix(), IsUploaded(),
+    // SortKey() and model space bounds.
+    template <typename ModelPtrs>
+    void Build(const ModelPtrs& models, const Frustum* frustums, size_t viewCount) {
+        if (viewCount > MaxViews) throw std::runtime_error{"Too many views"};
+        items.clear();
+        for (const auto& model : models) {
+            if (!model->IsUploaded()) continue;
+            const auto world = model->GetMatrix();
+            const auto worldBounds = TransformBounds(model->bounds, world);
+            uint32_t viewMask = 0;
+            for (size_t view = 0; view < viewCount; ++view)
+                if (frustums[view].Intersects(worldBounds)) viewMask |= 1u << view;
+            if (viewMask) items.push_back(Item{&*model, world.Transposed(), viewMask});
+        }
+        std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+            return a.model->SortKey() < b.model->SortKey();
+        });
+    }
+
+    // Issues the draws for one view. Device needs SetUniform(name, count, floats) and
+    // Draw(model).
+    template <typename Device>
+    void Render(Device& device, size_t view) const {
+        for (const auto& item : items) {
+            if (!(item.viewMask & (1u << view))) continue;
+            device.SetUniform("World", 16, &item.world.M[0][0]);
+            device.Draw(*item.model);
+        }
+    }
+};
@@ -0,0 +1,141 @@
+// Tests for UploadQueue and AssetLoader, driven by a stand-in for the render device. Prints each
+// failed check and returns non-zero if there were any.
+
+#include "asset_loader.h"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << endl; \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (false)
+
+// Records the uploads applied to it, in order.
+struct StubTarget {
+    vector<int> applied;
+};
+
+using Queue = UploadQueue<StubTarget>;
+using Loader = AssetLoader<StubTarget>;
+
+Queue::UploadFunc Apply(int id) {
+    return [id](StubTarget& target) { target.applied.push_back(id); };
+}
+
+// Drains loader until future is ready or a few seconds have passed, returns whether it is ready.
+bool DrainUntilReady(Loader& loader, StubTarget& target, const shared_future<void>& future) {
+    const auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (future.wait_for(chrono::milliseconds(1)) != future_status::ready) {
+        if (chrono::steady_clock::now() > deadline) return false;
+        loader.uploads.Drain(target, 1000);
+    }
+    return true;
+}
+
+template <typename Exception>
+bool Throws(const shared_future<void>& future) {
+    try {
+        future.get();
+    } catch (const Exception&) {
+        return true;
+    } catch (...) {
+    }
+    return false;
+}
+
+void TestDrainRespectsByteBudget() {
+    Queue queue{8};
+    for (int i = 0; i < 3; ++i) queue.Push(400, Apply(i));
+    StubTarget target;
+    CHECK(queue.Drain(target, 1000) == 800);
+    CHECK(target.applied.size() == 2);
+    CHECK(queue.Drain(target, 1000) == 400);
+    CHECK(target.applied.size() == 3);
+    CHECK(queue.Drain(target, 1000) == 0);
+}
+
+void TestDrainAppliesOversizedFirstUpload() {
+    Queue queue{8};
+    queue.Push(5000, Apply(0));
+    queue.Push(10, Apply(1));
+    StubTarget target;
+    CHECK(queue.Drain(target, 1000) == 5000);
+    CHECK(target.applied == vector<int>{0});
+    CHECK(queue.Drain(target, 1000) == 10);
+    CHECK(target.applied == (vector<int>{0, 1}));
+}
+
+void TestDrainKeepsFifoOrder() {
+    Queue queue{8};
+    for (int i = 0; i < 5; ++i) queue.Push(1, Apply(i));
+    StubTarget target;
+    queue.Drain(target, 1000);
+    CHECK(target.applied == (vector<int>{0, 1, 2, 3, 4}));
+}
+
+void TestCloseReleasesBlockedProducer() {
+    Queue queue{1};
+    CHECK(queue.Push(1, Apply(0)));
+    bool pushed = true;
+    thread producer{[&queue, &pushed] { pushed = queue.Push(1, Apply(1)); }};
+    this_thread::sleep_for(chrono::milliseconds(50));  // Let the producer block on the full queue
+    queue.Close();
+    producer.join();
+    CHECK(!pushed);
+    StubTarget target;
+    CHECK(queue.Drain(target, 1000) == 0);
+    CHECK(!queue.Push(1, Apply(2)));
+}
+
+void TestLoaderCompletesFutureAfterUpload() {
+    Loader loader{2, 4};
+    StubTarget target;
+    const auto future = loader.Load([] { return Loader::Payload{100, Apply(7)}; });
+    CHECK(DrainUntilReady(loader, target, future));
+    CHECK(target.applied == vector<int>{7});
+}
+
+void TestLoaderReportsProduceException() {
+    Loader loader{1, 4};
+    StubTarget target;
+    const auto future = loader.Load([]() -> Loader::Payload { throw runtime_error{"produce"}; });
+    CHECK(DrainUntilReady(loader, target, future));
+    CHECK(Throws<runtime_error>(future));
+}
+
+void TestLoaderReportsUploadException() {
+    // One worker, so the failing upload is queued before the next one
+    Loader loader{1, 4};
+    StubTarget target;
+    const auto failing = loader.Load([] {
+        return Loader::Payload{100, [](StubTarget&) { throw runtime_error{"upload"}; }};
+    });
+    const auto next = loader.Load([] { return Loader::Payload{100, Apply(1)}; });
+    CHECK(DrainUntilReady(loader, target, next));
+    CHECK(Throws<runtime_error>(failing));
+    CHECK(target.applied == vector<int>{1});
+}
+
+int main() {
+    TestDrainRespectsByteBudget();
+    TestDrainAppliesOversizedFirstUpload();
+    TestDrainKeepsFifoOrder();
+    TestCloseReleasesBlockedProducer();
+    TestLoaderCompletesFutureAfterUpload();
+    TestLoaderReportsProduceException();
+    TestLoaderReportsUploadException();
+    if (failures) cerr << failures << " checks failed" << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+// Tests for the batch box geometry functions against the sample's original per box code. Prints
+// each failed check and returns non-zero if there were any.
+
+#include "scene_core.h"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace OVR;
+using namespace std;
+
+int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << endl; \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (false)
+
+// Model::AddSolidColorBox as it was before the batch builder, the expected output.
+void ReferenceBox(Mesh& mesh, const BoxDesc& b) {
+    const float x1 = b.x1, y1 = b.y1, z1 = b.z1, x2 = b.x2, y2 = b.y2, z2 = b.z2;
+    const uint16_t CubeIndices[] = {0,  1,  3,  3,  1,  2,  5,  4,  6,  6,  4,  7,
+                                    8,  9,  11, 11, 9,  10, 13, 12, 14, 14, 12, 15,
+                                    16, 17, 19, 19, 17, 18, 21, 20, 22, 22, 20, 23};
+
+    const uint16_t offset = static_cast<uint16_t>(mesh.vertices.size());
+    for (const auto& index : CubeIndices) mesh.indices.push_back(index + offset);
+
+    const Vector3f Vert[][2] = {
+        Vector3f(x1, y2, z1), Vector3f(z1, x1), Vector3f(x2, y2, z1), Vector3f(z1, x2),
+        Vector3f(x2, y2, z2), Vector3f(z2, x2), Vector3f(x1, y2, z2), Vector3f(z2, x1),
+        Vector3f(x1, y1, z1), Vector3f(z1, x1), Vector3f(x2, y1, z1), Vector3f(z1, x2),
+        Vector3f(x2, y1, z2), Vector3f(z2, x2), Vector3f(x1, y1, z2), Vector3f(z2, x1),
+        Vector3f(x1, y1, z2), Vector3f(z2, y1), Vector3f(x1, y1, z1), Vector3f(z1, y1),
+        Vector3f(x1, y2, z1), Vector3f(z1, y2), Vector3f(x1, y2, z2), Vector3f(z2, y2),
+        Vector3f(x2, y1, z2), Vector3f(z2, y1), Vector3f(x2, y1, z1), Vector3f(z1, y1),
+        Vector3f(x2, y2, z1), Vector3f(z1, y2), Vector3f(x2, y2, z2), Vector3f(z2, y2),
+        Vector3f(x1, y1, z1), Vector3f(x1, y1), Vector3f(x2, y1, z1), Vector3f(x2, y1),
+        Vector3f(x2, y2, z1), Vector3f(x2, y2), Vector3f(x1, y2, z1), Vector3f(x1, y2),
+        Vector3f(x1, y1, z2), Vector3f(x1, y1), Vector3f(x2, y1, z2), Vector3f(x2, y1),
+        Vector3f(x2, y2, z2), Vector3f(x2, y2), Vector3f(x1, y2, z2), Vector3f(x1, y2),
+    };
+
+    for (int v = 0; v < 24; ++v) {
+        Mesh::Vertex vvv;
+        vvv.pos = Vert[v][0];
+        vvv.u = Vert[v][1].x;
+        vvv.v = Vert[v][1].y;
+        vvv.c = b.c;
+        mesh.vertices.push_back(vvv);
+    }
+}
+
+bool SameVertex(const Mesh::Vertex& a, const Mesh::Vertex& b) {
+    return a.pos.x == b.pos.x && a.pos.y == b.pos.y && a.pos.z == b.pos.z && a.u == b.u &&
+           a.v == b.v && a.c.r == b.c.r && a.c.g == b.c.g && a.c.b == b.c.b && a.c.a == b.c.a;
+}
+
+bool SameMesh(const Mesh& a, const Mesh& b) {
+    if (a.vertices.size() != b.vertices.size() || a.indices != b.indices) return false;
+    for (size_t i = 0; i < a.vertices.size(); ++i)
+        if (!SameVertex(a.vertices[i], b.vertices[i])) return false;
+    return true;
+}
+
+vector<BoxDesc> RandomBoxes(size_t count) {
+    mt19937 rng{7};
+    uniform_real_distribution<float> position{-20.0f, 20.0f};
+    vector<BoxDesc> boxes(count);
+    for (auto& box : boxes) {
+        // Corners in either order, as the room's boxes use both
+        box = BoxDesc{position(rng), position(rng), position(rng), position(rng),
+                      position(rng), position(rng),
+                      Mesh::Color(static_cast<unsigned char>(rng()), 10, 20, 30)};
+    }
+    return boxes;
+}
+
+Mesh ReferenceMesh(const BoxDesc* boxes, size_t count) {
+    Mesh mesh;
+    for (size_t i = 0; i < count; ++i) ReferenceBox(mesh, boxes[i]);
+    return mesh;
+}
+
+void TestMatchesReference() {
+    const auto boxes = RandomBoxes(40);
+    const auto reference = ReferenceMesh(boxes.data(), boxes.size());
+
+    Mesh perBox;
+    for (const auto& b : boxes) perBox.AddSolidColorBox(b.x1, b.y1, b.z1, b.x2, b.y2, b.z2, b.c);
+    CHECK(SameMesh(perBox, reference));
+
+    // In two batches, so the second one starts at a non-zero vertex
+    Mesh batched;
+    batched.AddSolidColorBoxes(boxes.data(), 15);
+    batched.AddSolidColorBoxes(boxes.data() + 15, boxes.size() - 15);
+    CHECK(SameMesh(batched, reference));
+
+    // Straight to caller provided storage, indices relative to baseVertex
+    vector<Mesh::Vertex> vertices(boxes.size() * BoxVertexCount);
+    vector<uint16_t> indices(boxes.size() * BoxIndexCount);
+    WriteBoxes(boxes.data(), boxes.size(), vertices.data(), indices.data(), 100);
+    bool same = true;
+    for (size_t i = 0; i < vertices.size(); ++i)
+        same = same && SameVertex(vertices[i], reference.vertices[i]);
+    for (size_t i = 0; i < indices.size(); ++i)
+        same = same && indices[i] == reference.indices[i] + 100;
+    CHECK(same);
+}
+
+void TestThrowsPast16BitIndices() {
+    const auto boxes = RandomBoxes(MaxBoxesPerMesh + 1);
+    auto throwsRuntimeError = [](Mesh& mesh, const BoxDesc* boxes, size_t count) {
+        try {
+            mesh.AddSolidColorBoxes(boxes, count);
+        } catch (const runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+
+    Mesh full;
+    CHECK(!throwsRuntimeError(full, boxes.data(), MaxBoxesPerMesh));
+    CHECK(full.vertices.size() == MaxBoxesPerMesh * BoxVertexCount);
+    CHECK(throwsRuntimeError(full, boxes.data(), 1));
+    CHECK(full.vertices.size() == MaxBoxesPerMesh * BoxVertexCount);  // Left unchanged
+
+    Mesh tooMany;
+    CHECK(throwsRuntimeError(tooMany, boxes.data(), MaxBoxesPerMesh + 1));
+    CHECK(tooMany.vertices.empty() && tooMany.indices.empty());
+
+    // Counts the vertices already in the mesh
+    Mesh started;
+    started.AddSolidColorBoxes(boxes.data(), 1);
+    CHECK(throwsRuntimeError(started, boxes.data(), MaxBoxesPerMesh));
+    CHECK(!throwsRuntimeError(started, boxes.data(), MaxBoxesPerMesh - 1));
+}
+
+void TestBuildBoxMeshesSplitsAtMaxBoxesPerMesh() {
+    const auto count = 2 * MaxBoxesPerMesh + 5;
+    const auto boxes = RandomBoxes(count);
+    const auto single = BuildBoxMeshes(boxes.data(), count, 1);
+    const auto threaded = BuildBoxMeshes(boxes.data(), count, 4);
+
+    CHECK(single.size() == 3);
+    CHECK(threaded.size() == single.size());
+    for (size_t m = 0; m < single.size() && m < threaded.size(); ++m) {
+        const auto first = m * MaxBoxesPerMesh;
+        const auto meshBoxes = min(MaxBoxesPerMesh, count - first);
+        CHECK(single[m].vertices.size() == meshBoxes * BoxVertexCount);
+        CHECK(SameMesh(single[m], ReferenceMesh(&boxes[first], meshBoxes)));
+        CHECK(SameMesh(threaded[m], single[m]));
+    }
+
+    CHECK(BuildBoxMeshes(boxes.data(), 0, 4).empty());
+}
+
+int main() {
+    TestMatchesReference();
+    TestThrowsPast16BitIndices();
+    TestBuildBoxMeshesSplitsAtMaxBoxesPerMesh();
+    if (failures) cerr << failures << " checks failed" << endl;
+    return failures ? 1 : 0;
+}
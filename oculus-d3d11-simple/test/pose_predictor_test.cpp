@@ -0,0 +1,160 @@
+// Tests for PosePredictor against analytic head motion. Prints each failed check and returns
+// non-zero if there were any.
+
+#include "pose_predictor.h"
+
+#include <iostream>
+
+using namespace OVR;
+using namespace std;
+
+int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << endl; \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (false)
+
+const double SampleInterval = 0.001;  // Seconds, the DK2 tracker rate
+
+// Radians between two orientations.
+float AngleBetween(const Quatf& a, const Quatf& b) {
+    return RotationVector(a * b.Inverted()).Length();
+}
+
+float Distance(const Vector3f& a, const Vector3f& b) { return (a - b).Length(); }
+
+// Head turning and moving at constant velocities, plus a constant linear acceleration.
+struct Motion {
+    Vector3f angularVelocity, linearVelocity, linearAcceleration;
+
+    PoseSample At(double time) const {
+        const auto t = static_cast<float>(time);
+        return PoseSample{time, RotationFromVector(angularVelocity * t),
+                          linearVelocity * t + linearAcceleration * (0.5f * t * t)};
+    }
+
+    // Adds samples for the first count sample intervals, returns the last sample's time.
+    double Feed(PosePredictor& predictor, int count) const {
+        for (int i = 0; i < count; ++i) predictor.AddSample(At(i * SampleInterval));
+        return (count - 1) * SampleInterval;
+    }
+};
+
+void TestConstantVelocityIsExact() {
+    const Motion motion{Vector3f{0.5f, 2.0f, 0.0f}, Vector3f{0.3f, 0.0f, -0.2f}, Vector3f{}};
+    PosePredictor predictor;
+    const auto last = motion.Feed(predictor, 50);
+    const auto target = last + 0.02;
+    const auto predicted = predictor.Predict(target);
+    const auto actual = motion.At(target);
+    CHECK(predicted.time == target);
+    CHECK(AngleBetween(predicted.orientation, actual.orientation) < 1e-4f);
+    CHECK(Distance(predicted.position, actual.position) < 1e-5f);
+}
+
+void TestConstantAccelerationTerm() {
+    const Motion motion{Vector3f{}, Vector3f{}, Vector3f{2.0f, 0.0f, 0.0f}};
+    PosePredictor velocity, acceleration;
+    velocity.smoothing = acceleration.smoothing = 1.0f;
+    acceleration.mode = PosePredictor::Mode::ConstantAcceleration;
+    const auto last = motion.Feed(velocity, 50);
+    motion.Feed(acceleration, 50);
+
+    // Finite differences lag the velocity by half a sample, a * dt / 2 * horizon = 2e-5 m,
+    // ignoring the acceleration misses a * horizon^2 / 2 = 4e-4 m
+    const auto target = last + 0.02;
+    const auto actual = motion.At(target);
+    const auto accelerationError =
+        Distance(acceleration.Predict(target).position, actual.position);
+    const auto velocityError = Distance(velocity.Predict(target).position, actual.position);
+    CHECK(accelerationError < 3e-5f);
+    CHECK(velocityError > 3e-4f);
+}
+
+void TestPredictionIsClampedToMaxHorizon() {
+    const Motion motion{Vector3f{0.0f, 1.0f, 0.0f}, Vector3f{1.0f, 0.0f, 0.0f}, Vector3f{}};
+    PosePredictor predictor;
+    const auto last = motion.Feed(predictor, 50);
+    const auto clamped = predictor.Predict(last + predictor.maxHorizon);
+    const auto far = predictor.Predict(last + 1.0);
+    CHECK(AngleBetween(far.orientation, clamped.orientation) < 1e-6f);
+    CHECK(Distance(far.position, clamped.position) < 1e-6f);
+    CHECK(Distance(far.position, motion.At(last + predictor.maxHorizon).position) < 1e-4f);
+
+    // Targets in the past predict the latest sample
+    const auto past = predictor.Predict(last - 1.0);
+    CHECK(Distance(past.position, motion.At(last).position) < 1e-6f);
+}
+
+void TestRepeatedAndOutOfOrderSamplesAreIgnored() {
+    const Motion motion{Vector3f{0.0f, 1.0f, 0.0f}, Vector3f{1.0f, 0.0f, 0.0f}, Vector3f{}};
+    PosePredictor predictor;
+    const auto last = motion.Feed(predictor, 10);
+    const auto before = predictor.Predict(last + 0.02);
+
+    PoseSample repeated = motion.At(last);
+    repeated.position = Vector3f{5.0f, 5.0f, 5.0f};
+    predictor.AddSample(repeated);
+    predictor.AddSample(motion.At(last - 5 * SampleInterval));
+    CHECK(predictor.history.size() == 10);
+    const auto after = predictor.Predict(last + 0.02);
+    CHECK(AngleBetween(after.orientation, before.orientation) < 1e-6f);
+    CHECK(Distance(after.position, before.position) < 1e-6f);
+}
+
+void TestJumpsResetTheHistory() {
+    const Motion motion{Vector3f{0.0f, 1.0f, 0.0f}, Vector3f{1.0f, 0.0f, 0.0f}, Vector3f{}};
+    const auto checkRestarted = [](const PosePredictor& predictor, const PoseSample& jump) {
+        CHECK(predictor.history.size() == 1);
+        const auto predicted = predictor.Predict(jump.time + 0.02);
+        CHECK(AngleBetween(predicted.orientation, jump.orientation) < 1e-6f);
+        CHECK(Distance(predicted.position, jump.position) < 1e-6f);
+    };
+
+    // A half turn within one sample interval, as after a recenter
+    {
+        PosePredictor predictor;
+        const auto last = motion.Feed(predictor, 10);
+        PoseSample jump = motion.At(last + SampleInterval);
+        jump.orientation = RotationFromVector(Vector3f{0.0f, 3.0f, 0.0f}) * jump.orientation;
+        CHECK(3.0f / SampleInterval > predictor.maxAngularSpeed);
+        predictor.AddSample(jump);
+        checkRestarted(predictor, jump);
+    }
+
+    // A metre within one sample interval
+    {
+        PosePredictor predictor;
+        const auto last = motion.Feed(predictor, 10);
+        PoseSample jump = motion.At(last + SampleInterval);
+        jump.position = jump.position + Vector3f{0.0f, 0.0f, 1.0f};
+        CHECK(1.0f / SampleInterval > predictor.maxLinearSpeed);
+        predictor.AddSample(jump);
+        checkRestarted(predictor, jump);
+    }
+
+    // Explicit reset
+    {
+        PosePredictor predictor;
+        motion.Feed(predictor, 10);
+        predictor.Reset();
+        CHECK(predictor.history.empty());
+        const auto sample = motion.At(1.0);
+        predictor.AddSample(sample);
+        checkRestarted(predictor, sample);
+    }
+}
+
+int main() {
+    TestConstantVelocityIsExact();
+    TestConstantAccelerationTerm();
+    TestPredictionIsClampedToMaxHorizon();
+    TestRepeatedAndOutOfOrderSamplesAreIgnored();
+    TestJumpsResetTheHistory();
+    if (failures) cerr << failures << " checks failed" << endl;
+    return failures ? 1 : 0;
+}